@@ -0,0 +1,392 @@
+// ******************************
+// File name :: host/bench/ch1115_bench.cpp
+// Description :: ERMCH1115 OLED benchmark, draws the radio screens on the host
+// against the CH1115 model and reports SPI traffic and virtual time, the
+// display RAM is checked against the frame buffer after every update
+// Author :: Gavin Lyons
+// URL :: https://github.com/gavinlyonsrepo/FM_Radio_PICO
+// *****************************
+
+#include <string.h>
+#include <chrono>
+#include "host_sim.hpp"
+#include "ch1115_model.hpp"
+#include "ch1115/ER_OLEDM1_CH1115.hpp"
+#include "bitmapdata/bitmap_data.hpp"
+
+// === Setup ===
+
+// GPIO as wired on the radio, see main/radio/main.cpp
+const int8_t benchCD = 2;
+const int8_t benchCS = 4;
+
+CH1115Model oledModel(benchCD, benchCS);
+ERMCH1115 myOLED(benchCD, 3, benchCS, 18, 19);
+uint8_t screenBuffer[128 * (64 / 8)];
+uint8_t referenceBuffer[128 * (64 / 8)];
+uint32_t benchSeed = 12345;
+uint64_t operationStartUs = 0;
+uint32_t mismatches = 0;
+
+// === Function Prototypes ===
+void PrintHeader(void);
+void BeginOperation(void);
+void Report(const char *name);
+void ReportAsync(const char *name, uint64_t returnUs, bool check = true);
+void DrawRadioInfo(uint8_t sigLevel, uint32_t freqRadio, bool async = false);
+void DrawVolInfo(uint16_t barLength, bool muted, bool async = false);
+void PrintFrequency(uint32_t freqkHz);
+uint32_t CheckFastPaths(uint32_t cases);
+void TimeClears(void);
+uint32_t CheckGlyphs(uint32_t cases);
+void TimeTextLine(int16_t y);
+int16_t RandomRange(int16_t low, int16_t high);
+
+// === Main ====
+int main()
+{
+	host_spi_attach(spi0, &oledModel);
+	PrintHeader();
+
+	BeginOperation();
+	myOLED.OLEDbegin(0x80, spi0, 8000);
+	Report("OLEDbegin");
+	myOLED.setTextColor(FOREGROUND);
+	myOLED.setFontNum(OLEDFontType_Default);
+	BeginOperation();
+	myOLED.OLEDFillScreen(0x00, 0);
+	myOLED.OLEDbuffer = (uint8_t*) &screenBuffer;
+	myOLED.OLEDclearBuffer();
+	Report("fill screen");
+
+	BeginOperation();
+	DrawRadioInfo(12, 98400);
+	DrawVolInfo(40, false);
+	Report("first radio screen");
+
+	BeginOperation();
+	DrawRadioInfo(12, 98400);
+	Report("radio info redrawn");
+
+	BeginOperation();
+	DrawVolInfo(46, false);
+	Report("volume bar +6");
+
+	BeginOperation();
+	DrawVolInfo(46, true);
+	Report("mute icon");
+
+	BeginOperation();
+	DrawRadioInfo(9, 98400);
+	Report("signal level change");
+
+	BeginOperation();
+	DrawRadioInfo(9, 101100);
+	Report("new station");
+
+	BeginOperation();
+	myOLED.OLEDclearBuffer();
+	myOLED.setFontNum(OLEDFontType_Default);
+	for (uint8_t i = 0; i < 6; i++) {
+		myOLED.setCursor(30, (i * 10) + 1);
+		PrintFrequency(88100 + i * 2900);
+	}
+	myOLED.drawRoundRect(20, 20, 60, 10, 5, FOREGROUND);
+	myOLED.OLEDupdate();
+	Report("menu screen");
+
+	BeginOperation();
+	myOLED.OLEDBitmap(0, 0, 16, 16, pRadioMastImage);
+	myOLED.OLEDupdate();
+	Report("direct bitmap then update");
+
+	BeginOperation();
+	myOLED.OLEDBuffer(0, 0, 128, 64, screenBuffer);
+	Report("whole buffer, for comparison");
+
+	myOLED.OLEDFillScreen(0x00, 0);
+	BeginOperation();
+	myOLED.OLEDupdate();
+	Report("update after fill screen");
+
+	// Byte mask fillRect and fast lines against drawLine, drawPixel per pixel
+	uint32_t differing = CheckFastPaths(3000);
+	printf("fast path cases 3000, differing from drawPixel %lu\r\n", (unsigned long)differing);
+	mismatches += differing;
+	TimeClears();
+	differing = CheckGlyphs(3000);
+	printf("glyph cases 3000, differing from drawPixel %lu\r\n", (unsigned long)differing);
+	mismatches += differing;
+	TimeTextLine(56);
+	TimeTextLine(37);
+	myOLED.OLEDbuffer = (uint8_t*) &screenBuffer;
+	myOLED.OLEDupdate();
+	BeginOperation();
+	for (uint8_t i = 0; i < 40; i++) {
+		myOLED.fillRect(RandomRange(-10, 127), RandomRange(-10, 63), RandomRange(1, 40), RandomRange(1, 30), i % 3);
+		myOLED.drawFastHLine(RandomRange(-10, 127), RandomRange(0, 63), RandomRange(1, 60), INVERSE);
+		myOLED.drawFastVLine(RandomRange(0, 127), RandomRange(-10, 63), RandomRange(1, 40), INVERSE);
+	}
+	myOLED.setFontNum(OLEDFontType_Tiny);
+	for (uint8_t i = 0; i < 12; i++) {
+		myOLED.setTextColor(i % 3, (i / 3) % 3);
+		myOLED.setCursor(RandomRange(-10, 120), RandomRange(-6, 60));
+		myOLED.print("98.4 MHz");
+	}
+	myOLED.setTextColor(FOREGROUND);
+	myOLED.OLEDupdate();
+	Report("fast path shapes then update");
+
+	// DMA updates, the CPU is back once the spans are listed and the first is started
+	myOLED.OLEDbeginAsync();
+	printf("%-30s %9s %9s %6s %6s\r\n", "dma update", "return uS", "frame uS", "spans", "data B");
+	BeginOperation();
+	myOLED.OLEDclearBuffer();
+	DrawRadioInfo(12, 98400, true);
+	ReportAsync("radio screen, full page", host_sim_time_us() - operationStartUs);
+
+	BeginOperation();
+	DrawVolInfo(52, false, true);
+	ReportAsync("volume area", host_sim_time_us() - operationStartUs);
+
+	BeginOperation();
+	myOLED.OLEDclearBuffer();
+	myOLED.OLEDupdateAsync();
+	uint64_t returnUs = host_sim_time_us() - operationStartUs;
+	uint32_t drawn = 0;
+	while (myOLED.OLEDIsBusy()) { // draw the next frame while this one streams
+		myOLED.drawPixel(drawn % 128, 50 + (drawn / 128) % 14, FOREGROUND);
+		drawn++;
+		tight_loop_contents(); // host drawing takes no virtual time, 1 uS a pixel
+	}
+	ReportAsync("clear screen, drawing on", returnUs, false);
+	printf("pixels drawn while the clear streamed %lu, frames %lu, longest %lu uS\r\n",
+		(unsigned long)drawn, (unsigned long)myOLED.OLEDgetFrameStats().frames,
+		(unsigned long)myOLED.OLEDgetFrameStats().maxFrameUs);
+	myOLED.OLEDupdateAsync();
+
+	myOLED.OLEDwaitAsync();
+	if (!oledModel.matches(screenBuffer)) mismatches++;
+	printf("display RAM mismatches %lu\r\n", (unsigned long)mismatches);
+	return mismatches == 0 ? 0 : 1;
+}
+
+// === Function Space ===
+
+void PrintHeader(void)
+{
+	printf("%-30s %6s %6s %6s %9s %9s %9s %9s\r\n", "operation", "calls", "cmd B", "data B",
+		"spi ms", "sleep ms", "cpu ms", "total ms");
+}
+
+// Reset statistics before one operation
+void BeginOperation(void)
+{
+	host_sim_reset_stats();
+	oledModel.resetCounts();
+	operationStartUs = host_sim_time_us();
+}
+
+// Print one row of the report and check the display RAM against the buffer
+// Param1 :: name of the operation
+void Report(const char *name)
+{
+	const HostSimStats &stats = host_sim_stats();
+	bool same = oledModel.matches(screenBuffer);
+	if (!same) mismatches++;
+	printf("%-30s %6lu %6lu %6lu %9.3f %9.3f %9.3f %9.3f%s\r\n", name, (unsigned long)stats.spiWrites,
+		(unsigned long)oledModel.getCommandBytes(), (unsigned long)oledModel.getDataBytes(),
+		stats.spiUs / 1000.0, stats.sleepUs / 1000.0, stats.cpuUs / 1000.0,
+		(host_sim_time_us() - operationStartUs) / 1000.0, same ? "" : "  RAM MISMATCH");
+}
+
+// Wait for a DMA update and print one row, checking the display RAM
+// Param1 :: name of the operation
+// Param2 :: returnUs , time until the update call returned
+// Param3 :: check , false if the buffer was drawn on after the update started
+void ReportAsync(const char *name, uint64_t returnUs, bool check)
+{
+	myOLED.OLEDwaitAsync();
+	const ERMCH1115_FrameStats_t &stats = myOLED.OLEDgetFrameStats();
+	bool same = !check || oledModel.matches(screenBuffer);
+	if (!same) mismatches++;
+	printf("%-30s %9lu %9lu %6lu %6lu%s\r\n", name, (unsigned long)returnUs,
+		(unsigned long)stats.lastFrameUs, (unsigned long)stats.spans, (unsigned long)stats.bytes,
+		same ? "" : "  RAM MISMATCH");
+}
+
+// Radio area as drawn by DisplayRadioInfo in main.cpp
+// Param1 :: sigLevel , already mapped to 5-36
+// Param2 :: freqRadio , kHz
+// Param3 :: async , update by DMA, returns once started
+void DrawRadioInfo(uint8_t sigLevel, uint32_t freqRadio, bool async)
+{
+	myOLED.fillRect(0, 0, 128, 32, BACKGROUND);
+	myOLED.drawBitmap(0, 0, pRadioMastImage, 16, 16, BACKGROUND, FOREGROUND);
+	myOLED.drawBitmap(1, 17, pSignalImage, 16, 8, FOREGROUND, BACKGROUND);
+	myOLED.drawRoundRect(40, 17, 80, 10, 5, FOREGROUND);
+	myOLED.fillRoundRect(40, 17, sigLevel * 2, 10, 5, FOREGROUND);
+	myOLED.setCursor(22, 0);
+	myOLED.setTextSize(2);
+	myOLED.setFontNum(OLEDFontType_Homespun);
+	PrintFrequency(freqRadio);
+	myOLED.setTextSize(1);
+	myOLED.setFontNum(OLEDFontType_Tiny);
+	myOLED.setCursor(110, 8);
+	myOLED.print(" MHz");
+	myOLED.setCursor(20, 20);
+	myOLED.print(sigLevel);
+	if (async) myOLED.OLEDupdateAsync();
+	else myOLED.OLEDupdate();
+}
+
+// Volume area as drawn by DisplayVolInfo in main.cpp
+// Param1 :: barLength , 5-75
+// Param2 :: muted , draw the mute icon instead of the bar
+// Param3 :: async , update by DMA, returns once started
+void DrawVolInfo(uint16_t barLength, bool muted, bool async)
+{
+	myOLED.fillRect(0, 32, 128, 16, BACKGROUND);
+	if (!muted) {
+		myOLED.drawBitmap(1, 30, pVolumeImage, 16, 16, FOREGROUND, BACKGROUND);
+		myOLED.drawRoundRect(40, 32, 80, 10, 5, FOREGROUND);
+		myOLED.fillRoundRect(40, 32, barLength, 10, 5, FOREGROUND);
+		myOLED.setCursor(20, 36);
+		myOLED.setFontNum(OLEDFontType_Tiny);
+		myOLED.print(barLength);
+	} else {
+		myOLED.drawBitmap(1, 30, pMuteImage, 16, 16, BACKGROUND, FOREGROUND);
+	}
+	if (async) myOLED.OLEDupdateAsync();
+	else myOLED.OLEDupdate();
+}
+
+// Draw random rectangles and lines both ways and compare the buffers
+// Param1 :: cases , shapes of each kind in each colour
+// Returns :: cases whose buffers differ
+// Notes :: The reference is the graphics class code, drawLine per column,
+// with sizes under 1 and shapes partly or wholly off screen included.
+uint32_t CheckFastPaths(uint32_t cases)
+{
+	uint32_t differing = 0;
+	for (uint32_t i = 0; i < cases; i++) {
+		for (uint16_t n = 0; n < sizeof(screenBuffer); n++) screenBuffer[n] = (uint8_t)RandomRange(0, 255);
+		memcpy(referenceBuffer, screenBuffer, sizeof(screenBuffer));
+		int16_t x = RandomRange(-40, 140), y = RandomRange(-40, 80);
+		int16_t w = RandomRange(-8, 140), h = RandomRange(-8, 80);
+		uint8_t colour = i % 3, shape = (i / 3) % 3;
+
+		myOLED.OLEDbuffer = (uint8_t*) &referenceBuffer;
+		switch (shape) {
+			case 0: for (int16_t col = x; col < x + w; col++) myOLED.drawLine(col, y, col, y + h - 1, colour); break;
+			case 1: myOLED.drawLine(x, y, x + w - 1, y, colour); break;
+			case 2: myOLED.drawLine(x, y, x, y + h - 1, colour); break;
+		}
+		myOLED.OLEDbuffer = (uint8_t*) &screenBuffer;
+		switch (shape) {
+			case 0: myOLED.fillRect(x, y, w, h, colour); break;
+			case 1: myOLED.drawFastHLine(x, y, w, colour); break;
+			case 2: myOLED.drawFastVLine(x, y, h, colour); break;
+		}
+		if (memcmp(screenBuffer, referenceBuffer, sizeof(screenBuffer)) != 0) {
+			if (differing++ == 0) printf("first differing case: shape %u x %d y %d w %d h %d colour %u\r\n",
+				shape, x, y, w, h, colour);
+		}
+	}
+	myOLED.OLEDclearBuffer();
+	return differing;
+}
+
+// Host time of the two clears of main.cpp, fillRect against drawLine per column
+void TimeClears(void)
+{
+	const uint32_t loops = 2000;
+	myOLED.OLEDbuffer = (uint8_t*) &referenceBuffer;
+	auto start = std::chrono::steady_clock::now();
+	for (uint32_t i = 0; i < loops; i++) {
+		for (int16_t col = 0; col < 128; col++) myOLED.drawLine(col, 0, col, 31, BACKGROUND);
+		for (int16_t col = 0; col < 128; col++) myOLED.drawLine(col, 32, col, 47, BACKGROUND);
+	}
+	auto middle = std::chrono::steady_clock::now();
+	for (uint32_t i = 0; i < loops; i++) {
+		myOLED.fillRect(0, 0, 128, 32, BACKGROUND);
+		myOLED.fillRect(0, 32, 128, 16, BACKGROUND);
+	}
+	auto end = std::chrono::steady_clock::now();
+	printf("host nS per radio screen clear: drawPixel %lld, byte mask %lld\r\n",
+		(long long)(std::chrono::duration_cast<std::chrono::nanoseconds>(middle - start).count() / loops),
+		(long long)(std::chrono::duration_cast<std::chrono::nanoseconds>(end - middle).count() / loops));
+}
+
+// Draw random characters of the 8 pixel fonts both ways and compare the buffers
+// Param1 :: cases , characters drawn
+// Returns :: cases whose buffers differ
+// Notes :: The reference is the graphics class drawChar, drawPixel per pixel,
+// in all colour and background pairs, on and off the page boundaries.
+uint32_t CheckGlyphs(uint32_t cases)
+{
+	struct {OLEDFontType_e font; uint8_t first; uint8_t last;} fonts[] = {
+		{OLEDFontType_Default, 0x00, 0xFE}, {OLEDFontType_Thick, 0x20, 0x5A},
+		{OLEDFontType_SevenSeg, 0x20, 0x7A}, {OLEDFontType_Wide, 0x20, 0x5A},
+		{OLEDFontType_Tiny, 0x20, 0x7F}, {OLEDFontType_Homespun, 0x20, 0x7E}};
+	uint32_t differing = 0;
+	for (uint32_t i = 0; i < cases; i++) {
+		for (uint16_t n = 0; n < sizeof(screenBuffer); n++) screenBuffer[n] = (uint8_t)RandomRange(0, 255);
+		memcpy(referenceBuffer, screenBuffer, sizeof(screenBuffer));
+		uint8_t f = i % 6, colour = (i / 6) % 3, bg = (i / 18) % 3;
+		int16_t x = RandomRange(-10, 130), y = RandomRange(-10, 70);
+		unsigned char c = (unsigned char)RandomRange(fonts[f].first, fonts[f].last);
+		myOLED.setFontNum(fonts[f].font);
+
+		myOLED.OLEDbuffer = (uint8_t*) &referenceBuffer;
+		myOLED.ERMCH1115_graphics::drawChar(x, y, c, colour, bg, 1);
+		myOLED.OLEDbuffer = (uint8_t*) &screenBuffer;
+		myOLED.drawChar(x, y, c, colour, bg, 1);
+		if (memcmp(screenBuffer, referenceBuffer, sizeof(screenBuffer)) != 0) {
+			if (differing++ == 0) printf("first differing glyph: font %u char %u x %d y %d colour %u bg %u\r\n",
+				fonts[f].font, c, x, y, colour, bg);
+		}
+	}
+	myOLED.OLEDclearBuffer();
+	return differing;
+}
+
+// Host time of a full line of tiny text, 32 characters, blitter against drawPixel
+// Param1 :: y , 56 is on a page boundary, 37 is not
+void TimeTextLine(int16_t y)
+{
+	const uint32_t loops = 2000;
+	const char *line = "88.10 MHz 12 dB Vol 46 T 21.5 C ";
+	myOLED.OLEDbuffer = (uint8_t*) &referenceBuffer;
+	myOLED.setFontNum(OLEDFontType_Tiny);
+	auto start = std::chrono::steady_clock::now();
+	for (uint32_t i = 0; i < loops; i++) {
+		for (uint8_t n = 0; n < 32; n++) myOLED.ERMCH1115_graphics::drawChar(n * 4, y, line[n], FOREGROUND, BACKGROUND, 1);
+	}
+	auto middle = std::chrono::steady_clock::now();
+	for (uint32_t i = 0; i < loops; i++) {
+		myOLED.setCursor(0, y);
+		myOLED.setTextWrap(false);
+		myOLED.print(line);
+	}
+	auto end = std::chrono::steady_clock::now();
+	myOLED.setTextWrap(true);
+	printf("host nS per line of tiny text at y %d: drawPixel %lld, column blit %lld\r\n", y,
+		(long long)(std::chrono::duration_cast<std::chrono::nanoseconds>(middle - start).count() / loops),
+		(long long)(std::chrono::duration_cast<std::chrono::nanoseconds>(end - middle).count() / loops));
+}
+
+// Returns :: pseudo random number from low to high, same sequence every run
+int16_t RandomRange(int16_t low, int16_t high)
+{
+	benchSeed = benchSeed * 1103515245u + 12345u;
+	return low + (int16_t)((benchSeed >> 16) % (uint32_t)(high - low + 1));
+}
+
+// Param1 :: freqkHz , printed in MHz with two decimal places
+void PrintFrequency(uint32_t freqkHz)
+{
+	char freqText[12];
+	snprintf(freqText, sizeof(freqText), "%lu.%02lu", (unsigned long)(freqkHz / 1000), (unsigned long)((freqkHz % 1000) / 10));
+	myOLED.print(freqText);
+}
@@ -0,0 +1,459 @@
+// ******************************
+// File name :: host/bench/main.cpp
+// Description :: TEA5767 tuning benchmark, runs the radio driver against the
+// behavioural model on the host and reports I2C traffic and virtual time
+// Author :: Gavin Lyons
+// URL :: https://github.com/gavinlyonsrepo/FM_Radio_PICO
+// *****************************
+
+#include <string.h>
+#include "host_sim.hpp"
+#include "tea5767_model.hpp"
+#include "tea5767/tea5767.hpp"
+#include "tea5767/tea5767_scan.hpp"
+#include "tea5767/tea5767_monitor.hpp"
+#include "tea5767/tea5767_af.hpp"
+#include "i2casync/i2c_async.hpp"
+#include "flashstore/flash_store.hpp"
+
+// === Setup ===
+
+// Synthetic spectrum, a mix of strong, weak, mono and close spaced stations
+const TEA5767ModelStation benchStations[] = {
+	{88100, 9, true},  {89300, 6, false}, {91000, 12, true}, {92200, 7, true},
+	{94700, 4, false}, {96300, 11, true}, {97000, 5, false}, {98400, 13, true},
+	{100200, 8, true}, {101100, 10, true}, {102600, 9, false}, {104800, 6, true},
+	{106150, 12, true}, {107700, 7, false}
+};
+
+// US spectrum, odd 200 kHz channels only
+const TEA5767ModelStation usStations[] = {
+	{88100, 9, true},  {89300, 6, false}, {91100, 12, true}, {92300, 7, true},
+	{94700, 4, false}, {96300, 11, true}, {97100, 5, false}, {98500, 13, true},
+	{100300, 8, true}, {101100, 10, true}, {102700, 9, false}, {104900, 6, true},
+	{106100, 12, true}, {107700, 7, false}
+};
+
+// Japan spectrum, both sides of the 91 MHz chip band limit
+const TEA5767ModelStation japanStations[] = {
+	{76500, 9, true},  {78900, 11, true}, {80000, 7, false}, {82500, 12, true},
+	{85200, 6, true},  {89700, 10, true}, {90500, 8, false}, {92400, 11, true},
+	{94100, 7, true}
+};
+
+const int8_t benchReadyPin = 22; // stand-in GPIO wired to SWPORT1
+
+TEA5767Model radioModel;
+TEA5767N radio;
+I2CAsync radioBus(i2c1);
+TEA5767Scan radioScan(radio);
+TEA5767Monitor radioMonitor(radio);
+TEA5767AltFreq radioAF(radio, radioMonitor);
+const TEA5767_AFNetwork_t benchNetwork = {{96300, 91000, 104800, 0}}; // one programme on three frequencies
+TEA5767N_Mock mockRadio; // same driver on the mock backend, routed to the model
+TEA5767_NoiseProfile_t noiseProfile = {};
+FlashStore noiseStore(FLASH_STORE_SECTOR_NOISE, 0x4E4F4931); // "NOI1"
+TEA5767_SkipList_t skipList = {};
+FlashStore skipStore(FLASH_STORE_SECTOR_SKIP, 0x534B5031); // "SKP1"
+FlashStore presetStore(FLASH_STORE_SECTOR_PRESETS, 0x50524531); // "PRE1"
+
+// === Function Prototypes ===
+void PrintHeader(void);
+void Report(const char *name, uint32_t resultKHz, uint32_t repeats);
+void BeginOperation(void);
+int MockToModel(void *userData, uint8_t address, bool read, uint8_t *data, size_t len);
+bool FollowFade(uint32_t fadingKHz, uint8_t fadedLevel);
+void SweepBand(const char *name, bool software, bool verify,
+	const TEA5767ModelStation *stations = benchStations,
+	uint8_t stationCount = sizeof(benchStations) / sizeof(benchStations[0]));
+
+// === Main ====
+int main()
+{
+	host_i2c_attach(i2c1, TEA5767_I2C_ADDRESS, &radioModel);
+	radioModel.setStations(benchStations, sizeof(benchStations) / sizeof(benchStations[0]));
+	radio.begin(TEA5767_I2C_ADDRESS, i2c1, 14, 15, 100);
+
+	PrintHeader();
+
+	BeginOperation();
+	radio.selectFrequency(98400);
+	Report("selectFrequency cold", radioModel.getTunedKHz(), 1);
+
+	radio.selectFrequency(96300);
+	BeginOperation();
+	radio.selectFrequency(98400);
+	radio.selectFrequency(96300);
+	radio.selectFrequency(98400);
+	Report("selectFrequency cached", radioModel.getTunedKHz(), 3);
+
+	BeginOperation();
+	for (uint8_t i = 0; i < 10; i++) {
+		radio.tuneChannel(true);
+	}
+	Report("fine tune next channel", radioModel.getTunedKHz(), 10);
+
+	BeginOperation();
+	radio.getSignalLevel();
+	radio.isStereo();
+	Report("level+stereo", radioModel.getTunedKHz(), 1);
+
+	radio.selectFrequency(98400);
+	radio.setSearchUp();
+	radio.setSearchMidStopLevel();
+	BeginOperation();
+	radio.searchNext();
+	Report("searchNext up", radioModel.getTunedKHz(), 1);
+
+	BeginOperation();
+	radio.searchNextMuting();
+	Report("searchNextMuting up", radioModel.getTunedKHz(), 1);
+
+	BeginOperation();
+	radio.startsSearchFromBeginning();
+	Report("startsSearchFromBeginning", radioModel.getTunedKHz(), 1);
+
+	radio.setSearchDown();
+	BeginOperation();
+	radio.startsSearchFromEnd();
+	Report("startsSearchFromEnd", radioModel.getTunedKHz(), 1);
+
+	// low stop level, plain and verified
+	radio.setSearchUp();
+	radio.setSearchLowStopLevel();
+	radio.selectFrequency(98400);
+	BeginOperation();
+	radio.searchNext();
+	Report("searchNext low stop level", radioModel.getTunedKHz(), 1);
+
+	radio.selectFrequency(98400);
+	radio.setSeekVerify(true);
+	BeginOperation();
+	radio.searchNext();
+	Report("searchNext low verified", radioModel.getTunedKHz(), 1);
+	printf("verified seek passed %lu false stops\r\n", (unsigned long)radio.getSeekFalseStops());
+	radio.setSeekVerify(false);
+	radio.setSearchMidStopLevel();
+
+	radio.setSearchHighStopLevel();
+	radio.selectFrequency(98400);
+	BeginOperation();
+	radio.searchNext();
+	Report("searchNext high stop level", radioModel.getTunedKHz(), 1);
+
+	// SWPORT1 ready flag on a GPIO interrupt, no ready polling on the bus
+	radioModel.setSearchIndicatorPin(benchReadyPin);
+	radio.setReadyPin(benchReadyPin);
+	radio.selectFrequency(98400);
+	BeginOperation();
+	for (uint8_t i = 0; i < 10; i++) {
+		radio.tuneChannel(true);
+	}
+	Report("fine tune ready pin", radioModel.getTunedKHz(), 10);
+
+	radio.selectFrequency(98400);
+	BeginOperation();
+	radio.searchNext();
+	Report("searchNext high ready pin", radioModel.getTunedKHz(), 1);
+	printf("ready pin edges %lu\r\n", (unsigned long)radio.getReadyEdges());
+	radio.setReadyPin(TEA5767_READY_PIN_NONE);
+	radio.setSearchMidStopLevel();
+	radioModel.setSearchIndicatorPin(-1);
+
+	// standby keeping the tuning, against a restart with connect check and injection probe
+	radio.selectFrequency(96300);
+	BeginOperation();
+	radio.standby();
+	Report("standby", radioModel.getTunedKHz(), 1);
+
+	BeginOperation();
+	radio.resume();
+	Report("resume", radioModel.getTunedKHz(), 1);
+	printf("resume wake to audio %lu uS\r\n", (unsigned long)radio.getWakeLatencyUs());
+
+	// buttons in standby, a seek is refused and a fine tune wakes the radio first
+	radio.standby();
+	bool seekRefused = !radio.seekStart(true);
+	BeginOperation();
+	radio.tuneChannel(true);
+	Report("fine tune from standby", radioModel.getTunedKHz(), 1);
+	printf("standby seek refused %s, standby after fine tune %s\r\n", seekRefused ? "yes" : "no",
+		radio.isStandBy() ? "yes" : "no");
+
+	radio.setStandByOn();
+	BeginOperation();
+	radio.CheckConnection();
+	radio.setStandByOff();
+	radio.clearInjectionCache();
+	radio.selectFrequency(96300);
+	Report("restart connect+probe", radioModel.getTunedKHz(), 1);
+
+	// hardware search against the coarse to fine software seek, whole band at low stop level
+	radio.setSearchUp();
+	radio.setSearchLowStopLevel();
+	SweepBand("sweep hardware seek", false, false);
+	SweepBand("sweep hardware seek verified", false, true);
+	SweepBand("sweep software seek", true, false);
+	SweepBand("sweep software seek verified", true, true);
+
+	// noisy part of the band, fixed stop level against a noise floor profile kept in flash
+	radioModel.setNoiseRegion(99000, 102950, 5);
+	SweepBand("sweep noisy hardware seek", false, false);
+	SweepBand("sweep noisy software seek", true, false);
+	BeginOperation();
+	radio.calibrateNoiseFloor(noiseProfile);
+	Report("noise floor calibration", radioModel.getTunedKHz(), 1);
+	TEA5767_NoiseProfile_t storedProfile = {};
+	BeginOperation();
+	noiseStore.save(&noiseProfile, sizeof(noiseProfile));
+	noiseStore.save(&noiseProfile, sizeof(noiseProfile)); // unchanged, not written again
+	bool loaded = noiseStore.load(&storedProfile, sizeof(storedProfile));
+	radio.setNoiseProfile(&storedProfile);
+	printf("noise profile in flash: %s, %lu sector erases, %lu pages, threshold 98.4 MHz %u, 101.5 MHz %u\r\n",
+		(loaded && memcmp(&storedProfile, &noiseProfile, sizeof(noiseProfile)) == 0) ? "loaded" : "failed",
+		(unsigned long)host_sim_stats().flashErases, (unsigned long)host_sim_stats().flashPages,
+		radio.getNoiseThreshold(98400), radio.getNoiseThreshold(101500));
+	SweepBand("sweep noisy hardware seek profile", false, false);
+	SweepBand("sweep noisy software seek profile", true, false);
+	radio.setNoiseProfile(nullptr);
+	radioModel.setNoiseRegion(0, 0, 0);
+
+	// band plans, the US 200 kHz raster against the same band stepped at 100 kHz
+	radioModel.setStations(usStations, sizeof(usStations) / sizeof(usStations[0]));
+	SweepBand("sweep US band on EU raster", true, false, usStations, sizeof(usStations) / sizeof(usStations[0]));
+	radio.setBandPlan(TEA5767_BAND_US);
+	SweepBand("sweep US band on US raster", true, false, usStations, sizeof(usStations) / sizeof(usStations[0]));
+	SweepBand("sweep US band hardware seek", false, false, usStations, sizeof(usStations) / sizeof(usStations[0]));
+	radioModel.setStations(japanStations, sizeof(japanStations) / sizeof(japanStations[0]));
+	radio.setBandPlan(TEA5767_BAND_JAPAN);
+	SweepBand("sweep Japan band hardware seek", false, false, japanStations, sizeof(japanStations) / sizeof(japanStations[0]));
+	SweepBand("sweep Japan band software seek", true, false, japanStations, sizeof(japanStations) / sizeof(japanStations[0]));
+	radioModel.setStations(benchStations, sizeof(benchStations) / sizeof(benchStations[0]));
+	radio.setBandPlan(TEA5767_BAND_EUROPE);
+	radio.setSearchMidStopLevel();
+
+	// auto wrap at the band edge, no dead end at 108 MHz
+	radio.setSeekWrap(true);
+	radio.selectFrequency(107700);
+	BeginOperation();
+	uint8_t bandLimit = radio.searchNext();
+	Report("searchNext wrap", radioModel.getTunedKHz(), 1);
+	radio.selectFrequency(107700);
+	BeginOperation();
+	bandLimit |= radio.softSearchNext();
+	Report("softSearchNext wrap", radioModel.getTunedKHz(), 1);
+	printf("wrap band limit reported %u\r\n", bandLimit);
+	radio.setSeekWrap(false);
+
+	// skip list, a stop on a skipped channel is searched past within the seek
+	radio.setSeekVerify(true);
+	radio.selectFrequency(96300);
+	BeginOperation();
+	radio.searchNext();
+	Report("searchNext no skip list", radioModel.getTunedKHz(), 1);
+	radio.setSkipList(&skipList);
+	radio.setChannelSkip(98400, true);
+	radio.setChannelSkip(100200, true);
+	radio.selectFrequency(96300);
+	BeginOperation();
+	radio.searchNext();
+	Report("searchNext 2 skipped", radioModel.getTunedKHz(), 1);
+	radio.selectFrequency(96300);
+	BeginOperation();
+	radio.softSearchNext();
+	Report("softSearchNext 2 skipped", radioModel.getTunedKHz(), 1);
+	skipStore.save(&skipList, sizeof(skipList));
+	TEA5767_SkipList_t storedSkips = {};
+	printf("skip list in flash: %s, %lu skipped stops passed\r\n",
+		(skipStore.load(&storedSkips, sizeof(storedSkips)) && memcmp(&storedSkips, &skipList, sizeof(skipList)) == 0) ? "loaded" : "failed",
+		(unsigned long)radio.getSeekSkippedStops());
+	radio.setSeekVerify(false);
+
+	// alternate frequency following, the tuned frequency fades and the best alternate is kept
+	radioMonitor.setRate(50, 500);
+	radioAF.setNetwork(&benchNetwork);
+	radio.selectFrequency(96300);
+	radioMonitor.clear();
+	BeginOperation();
+	bool followed = FollowFade(96300, 3);
+	Report("af fade to switch, first visit", radioModel.getTunedKHz(), 1);
+	printf("af switched %u, muted gap %lu uS, injection sides probed\r\n", followed,
+		(unsigned long)radioAF.getStats().lastSwitchUs);
+	radioModel.setStationLevel(96300, 11);
+	BeginOperation();
+	followed = FollowFade(91000, 3);
+	Report("af fade to switch, cached", radioModel.getTunedKHz(), 1);
+	printf("af switched %u, muted gap %lu uS, %lu checks, longest gap %lu uS\r\n", followed,
+		(unsigned long)radioAF.getStats().lastSwitchUs, (unsigned long)radioAF.getStats().checks,
+		(unsigned long)radioAF.getStats().maxGapUs);
+	radioModel.setStationLevel(91000, 12);
+	radioAF.setNetwork(nullptr);
+
+	radio.selectFrequency(98400);
+	radioBus.begin();
+	radio.setAsyncBus(&radioBus);
+	BeginOperation();
+	radio.seekStart(true);
+	while (!radio.seekPoll()) tight_loop_contents();
+	Report("seek async bus", radioModel.getTunedKHz(), 1);
+
+	BeginOperation();
+	radioScan.start();
+	while (radioScan.poll() < 100) tight_loop_contents();
+	Report("band scan async bus", radioModel.getTunedKHz(), 1);
+	printf("band scan found %u stations of %u, 2 skipped\r\n", radioScan.getCount(),
+		(unsigned)(sizeof(benchStations) / sizeof(benchStations[0])));
+	radio.setSkipList(nullptr);
+
+	// auto store, stations of the scan ranked by level, stereo and IF into the preset table
+	uint32_t ranked[TEA5767_PRESET_COUNT];
+	BeginOperation();
+	uint8_t rankedCount = radioScan.rankStations(ranked, TEA5767_PRESET_COUNT);
+	TEA5767_PresetTable_t presets = {};
+	for (uint8_t i = 0; i < rankedCount; i++) presets.preset[i].kHz[0] = ranked[i];
+	presets.count = rankedCount;
+	presetStore.save(&presets, sizeof(presets));
+	Report("auto store presets", radioModel.getTunedKHz(), 1);
+	TEA5767_PresetTable_t storedPresets = {};
+	printf("presets in flash: %s,", (presetStore.load(&storedPresets, sizeof(storedPresets)) &&
+		memcmp(&storedPresets, &presets, sizeof(presets)) == 0) ? "loaded" : "failed");
+	for (uint8_t i = 0; i < storedPresets.count; i++)
+		printf(" %lu", (unsigned long)storedPresets.preset[i].kHz[0]);
+	printf(" kHz\r\n");
+
+	// a blocking call that times out behind a queued transfer is taken off the queue
+	I2CAsyncBus sharedBus;
+	I2CAsyncTransfer ahead;
+	uint8_t statusAhead[5], statusBlocking[5];
+	sharedBus.setQueue(&radioBus);
+	radioBus.submitRead(ahead, TEA5767_I2C_ADDRESS, statusAhead, 5);
+	int timedOut = sharedBus.read(TEA5767_I2C_ADDRESS, statusBlocking, 5, 0);
+	bool leftQueued = radioBus.isBusy();
+	int readBack = sharedBus.read(TEA5767_I2C_ADDRESS, statusBlocking, 5, 50000);
+	printf("async bus timeout: returned %d, left queued %s, next read %d bytes\r\n", timedOut,
+		leftQueued ? "yes" : "no", readBack);
+	radio.setAsyncBus(nullptr);
+	radioBus.end();
+
+	size_t lastLen;
+	mockRadio.getBus().setHandler(MockToModel, &radioModel);
+	mockRadio.begin(TEA5767_I2C_ADDRESS, nullptr, 0, 0, 100);
+	mockRadio.selectFrequency(91000);
+	mockRadio.getBus().getLastWrite(lastLen);
+	printf("mock bus selectFrequency %lu kHz: %lu writes, %lu reads, %lu bytes, last write %u bytes\r\n",
+		(unsigned long)mockRadio.getTunedFrequencyInKHz(), (unsigned long)mockRadio.getBus().getWrites(),
+		(unsigned long)mockRadio.getBus().getReads(), (unsigned long)mockRadio.getBus().getBytes(), (unsigned)lastLen);
+
+	const TEA5767_SettleStats_t &settle = radio.getSettleStats();
+	printf("retune settle: %lu waits, %lu timeouts, min %lu uS, max %lu uS, average %lu uS, %lu short settles\r\n",
+		(unsigned long)settle.count, (unsigned long)settle.timeouts, (unsigned long)settle.minUs,
+		(unsigned long)settle.maxUs, (unsigned long)(settle.count ? settle.totalUs / settle.count : 0),
+		(unsigned long)settle.shortCount);
+
+	return 0;
+}
+
+// === End  of main ===
+
+
+// === Function Space ===
+
+// Print the report column headings
+void PrintHeader(void)
+{
+	printf("%-34s %6s %6s %6s %6s %9s %9s %9s %9s %8s\r\n", "operation", "writes", "reads",
+		"tx B", "rx B", "bus ms", "sleep ms", "cpu ms", "total ms", "MHz");
+}
+
+// Start measuring an operation, statistics and clock mark reset
+static uint64_t operationStartUs = 0;
+void BeginOperation(void)
+{
+	host_sim_reset_stats();
+	operationStartUs = host_sim_time_us();
+}
+
+// Mock bus handler, passes the transfer to the device model
+int MockToModel(void *userData, uint8_t, bool read, uint8_t *data, size_t len)
+{
+	TEA5767Model *model = (TEA5767Model *)userData;
+	return read ? model->read(data, len) : model->write(data, len);
+}
+
+// Fade a transmitter and run the monitor and follower until they switch
+// Param1 :: fadingKHz , the tuned frequency , Param2 :: fadedLevel
+// Returns :: bool true if the follower moved to an alternate within 10 S
+bool FollowFade(uint32_t fadingKHz, uint8_t fadedLevel)
+{
+	uint64_t startUs = host_sim_time_us();
+	radioModel.setStationLevel(fadingKHz, fadedLevel);
+	while (host_sim_time_us() - startUs < 10000000) {
+		radioMonitor.poll();
+		if (radioAF.poll()) return true;
+	}
+	return false;
+}
+
+// Seek up the whole band plan, each stop checked against the station list
+// Param1 :: name of the operation
+// Param2 :: software , true coarse to fine software seek, false chip search
+// Param3 :: verify , IF counter check of each stop, see setSeekVerify
+// Param4 :: stations , Param5 :: stationCount , the spectrum the model has
+// Notes :: A stop is a station if it is the nearest channel of the band plan to it.
+void SweepBand(const char *name, bool software, bool verify, const TEA5767ModelStation *stations, uint8_t stationCount)
+{
+	const TEA5767_BandPlan_t &plan = radio.getBandPlan();
+	const int32_t window = plan.rasterKHz / 2;
+	bool found[32] = {};
+	uint32_t stops = 0;
+	uint32_t falseStops = 0;
+	uint32_t stationsFound = 0;
+	uint32_t lastKHz = 0;
+
+	radio.setSeekVerify(verify);
+	radio.selectFrequency(TEA5767_NextChannel(plan, plan.lowKHz, false));
+	BeginOperation();
+	while ((software ? radio.softSearchNext() : radio.searchNext()) == 0) {
+		uint32_t kHz = radio.getTunedFrequencyInKHz();
+		if (kHz <= lastKHz) break;
+		lastKHz = kHz;
+		stops++;
+		bool real = false;
+		for (uint8_t i = 0; i < stationCount; i++) {
+			int32_t distance = (int32_t)stations[i].kHz - (int32_t)kHz;
+			if (distance < -window || distance > window) continue;
+			real = true;
+			if (!found[i]) stationsFound++;
+			found[i] = true;
+		}
+		if (!real) falseStops++;
+	}
+	uint64_t totalUs = host_sim_time_us() - operationStartUs;
+	Report(name, radioModel.getTunedKHz(), 1);
+	printf("  %lu stops, %lu of %u stations, %lu false stops (%lu%%), %.1f stations/s\r\n",
+		(unsigned long)stops, (unsigned long)stationsFound, stationCount, (unsigned long)falseStops,
+		(unsigned long)(stops ? falseStops * 100 / stops : 0), stationsFound * 1000000.0 / totalUs);
+	radio.setSeekVerify(false);
+}
+
+// Print one row of the report
+// Param1 :: name of the operation
+// Param2 :: resultKHz , frequency the model ended on, shown on the 50 kHz raster
+// Param3 :: repeats , times the operation ran, totals are divided by it
+void Report(const char *name, uint32_t resultKHz, uint32_t repeats)
+{
+	const HostSimStats &stats = host_sim_stats();
+	uint64_t totalUs = host_sim_time_us() - operationStartUs;
+	char label[40];
+	resultKHz = ((resultKHz + TEA5767_CHANNEL_KHZ / 2) / TEA5767_CHANNEL_KHZ) * TEA5767_CHANNEL_KHZ;
+	if (repeats > 1)
+		snprintf(label, sizeof(label), "%s (avg of %lu)", name, (unsigned long)repeats);
+	else
+		snprintf(label, sizeof(label), "%s", name);
+	printf("%-34s %6.1f %6.1f %6.1f %6.1f %9.3f %9.3f %9.3f %9.3f %4lu.%02lu\r\n", label,
+		(double)stats.writes / repeats, (double)stats.reads / repeats,
+		(double)stats.bytesWritten / repeats, (double)stats.bytesRead / repeats,
+		stats.busUs / 1000.0 / repeats, stats.sleepUs / 1000.0 / repeats,
+		stats.cpuUs / 1000.0 / repeats, totalUs / 1000.0 / repeats,
+		(unsigned long)(resultKHz / 1000), (unsigned long)((resultKHz % 1000) / 10));
+}
@@ -0,0 +1,43 @@
+/*
+ * Project Name: Host stand-in for the RPI PICO SDK
+ * File: ch1115_model.hpp
+ * Description: model of the CH1115 OLED controller on the stand-in SPI bus,
+ * decodes the address commands and keeps the display RAM, counts command
+ * and data bytes
+ * URL: https://github.com/gavinlyonsrepo/FM_Radio_PICO
+ */
+
+#ifndef CH1115_MODEL_h
+#define CH1115_MODEL_h
+
+#include "host_sim.hpp"
+
+#define CH1115_MODEL_WIDTH   128
+#define CH1115_MODEL_PAGES   8
+
+class CH1115Model : public HostSPIDevice {
+	public:
+	  CH1115Model(int8_t cdPin, int8_t csPin);
+
+	  void write(const uint8_t *src, size_t len) override;
+
+	  const uint8_t *getRAM() const;
+	  bool matches(const uint8_t *buffer) const;
+	  uint32_t getCommandBytes() const;
+	  uint32_t getDataBytes() const;
+	  void resetCounts();
+
+	private:
+	  void command(uint8_t byte);
+
+	  int8_t _cdPin;
+	  int8_t _csPin;
+	  uint8_t _ram[CH1115_MODEL_WIDTH * CH1115_MODEL_PAGES] = {};
+	  uint8_t _column = 0;
+	  uint8_t _page = 0;
+	  uint8_t _argBytes = 0;   // argument bytes still owed to the last command
+	  uint32_t _commandBytes = 0;
+	  uint32_t _dataBytes = 0;
+};
+
+#endif
@@ -0,0 +1,44 @@
+/*
+ * Project Name: Host stand-in for the RPI PICO SDK
+ * File: hardware/dma.h
+ * Description: stand-in header for host builds, a transfer to the SPI data
+ * register reaches the attached SPI device when triggered and completes on
+ * the virtual clock after its bus time, raising DMA_IRQ_0
+ * URL: https://github.com/gavinlyonsrepo/FM_Radio_PICO
+ */
+
+#ifndef HOST_HARDWARE_DMA_h
+#define HOST_HARDWARE_DMA_h
+
+#include "pico/stdlib.h"
+#include "hardware/irq.h"
+
+enum dma_channel_transfer_size {
+	DMA_SIZE_8 = 0,
+	DMA_SIZE_16 = 1,
+	DMA_SIZE_32 = 2
+};
+
+typedef struct {
+	enum dma_channel_transfer_size size;
+	bool readIncrement;
+	bool writeIncrement;
+	uint dreq;
+} dma_channel_config;
+
+int dma_claim_unused_channel(bool required);
+void dma_channel_unclaim(uint channel);
+dma_channel_config dma_channel_get_default_config(uint channel);
+void channel_config_set_transfer_data_size(dma_channel_config *c, enum dma_channel_transfer_size size);
+void channel_config_set_read_increment(dma_channel_config *c, bool incr);
+void channel_config_set_write_increment(dma_channel_config *c, bool incr);
+void channel_config_set_dreq(dma_channel_config *c, uint dreq);
+void dma_channel_configure(uint channel, const dma_channel_config *config, volatile void *write_addr,
+	const volatile void *read_addr, uint transfer_count, bool trigger);
+void dma_channel_transfer_from_buffer_now(uint channel, const volatile void *read_addr, uint32_t transfer_count);
+bool dma_channel_is_busy(uint channel);
+void dma_channel_set_irq0_enabled(uint channel, bool enabled);
+bool dma_channel_get_irq0_status(uint channel);
+void dma_channel_acknowledge_irq0(uint channel);
+
+#endif
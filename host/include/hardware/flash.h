@@ -0,0 +1,26 @@
+/*
+ * Project Name: Host stand-in for the RPI PICO SDK
+ * File: hardware/flash.h
+ * Description: stand-in header for host builds, flash is an array in memory
+ * mapped at XIP_BASE, erase and program follow the NOR flash rules
+ * URL: https://github.com/gavinlyonsrepo/FM_Radio_PICO
+ */
+
+#ifndef HOST_HARDWARE_FLASH_h
+#define HOST_HARDWARE_FLASH_h
+
+#include <stdint.h>
+#include <stddef.h>
+
+#define FLASH_PAGE_SIZE       (1u << 8)
+#define FLASH_SECTOR_SIZE     (1u << 12)
+#define PICO_FLASH_SIZE_BYTES (2 * 1024 * 1024)
+
+extern uint8_t host_flash[PICO_FLASH_SIZE_BYTES];
+#define XIP_BASE              ((uintptr_t)host_flash)
+
+// Offsets and counts must be sector aligned for erase, page aligned for program
+void flash_range_erase(uint32_t flash_offs, size_t count);
+void flash_range_program(uint32_t flash_offs, const uint8_t *data, size_t count);
+
+#endif
@@ -0,0 +1,50 @@
+/*
+ * Project Name: Host stand-in for the RPI PICO SDK
+ * File: hardware/gpio.h
+ * Description: stand-in header for host builds, pins are kept in memory
+ * and can be driven by device models
+ * URL: https://github.com/gavinlyonsrepo/FM_Radio_PICO
+ */
+
+#ifndef HOST_HARDWARE_GPIO_h
+#define HOST_HARDWARE_GPIO_h
+
+#include <stdint.h>
+#include <stdbool.h>
+#include "hardware/irq.h"
+#include "hardware/structs/sio.h"
+
+#define GPIO_OUT 1
+#define GPIO_IN  0
+
+enum gpio_function {
+	GPIO_FUNC_SPI = 1,
+	GPIO_FUNC_UART = 2,
+	GPIO_FUNC_I2C = 3,
+	GPIO_FUNC_SIO = 5,
+	GPIO_FUNC_NULL = 0x1f
+};
+
+enum gpio_irq_level {
+	GPIO_IRQ_LEVEL_LOW = 0x1u,
+	GPIO_IRQ_LEVEL_HIGH = 0x2u,
+	GPIO_IRQ_EDGE_FALL = 0x4u,
+	GPIO_IRQ_EDGE_RISE = 0x8u
+};
+
+void gpio_init(unsigned int gpio);
+void gpio_set_function(unsigned int gpio, enum gpio_function fn);
+void gpio_set_dir(unsigned int gpio, bool out);
+void gpio_put(unsigned int gpio, bool value);
+bool gpio_get(unsigned int gpio);
+void gpio_pull_up(unsigned int gpio);
+void gpio_pull_down(unsigned int gpio);
+
+// Edge events are raised when a device model drives the pin, see host_gpio_drive
+void gpio_set_irq_enabled(unsigned int gpio, uint32_t events, bool enabled);
+void gpio_add_raw_irq_handler_masked(uint32_t gpio_mask, irq_handler_t handler);
+void gpio_remove_raw_irq_handler_masked(uint32_t gpio_mask, irq_handler_t handler);
+uint32_t gpio_get_irq_event_mask(unsigned int gpio);
+void gpio_acknowledge_irq(unsigned int gpio, uint32_t events);
+
+#endif
@@ -0,0 +1,28 @@
+/*
+ * Project Name: Host stand-in for the RPI PICO SDK
+ * File: hardware/i2c.h
+ * Description: stand-in header for host builds, transfers go to device
+ * models attached with host_i2c_attach (see host_sim.hpp)
+ * URL: https://github.com/gavinlyonsrepo/FM_Radio_PICO
+ */
+
+#ifndef HOST_HARDWARE_I2C_h
+#define HOST_HARDWARE_I2C_h
+
+#include "pico/stdlib.h"
+
+typedef struct i2c_inst i2c_inst_t;
+
+extern i2c_inst_t i2c0_inst;
+extern i2c_inst_t i2c1_inst;
+#define i2c0 (&i2c0_inst)
+#define i2c1 (&i2c1_inst)
+
+uint i2c_init(i2c_inst_t *i2c, uint baudrate);
+void i2c_deinit(i2c_inst_t *i2c);
+int i2c_write_timeout_us(i2c_inst_t *i2c, uint8_t addr, const uint8_t *src, size_t len, bool nostop, uint timeout_us);
+int i2c_read_timeout_us(i2c_inst_t *i2c, uint8_t addr, uint8_t *dst, size_t len, bool nostop, uint timeout_us);
+int i2c_write_blocking(i2c_inst_t *i2c, uint8_t addr, const uint8_t *src, size_t len, bool nostop);
+int i2c_read_blocking(i2c_inst_t *i2c, uint8_t addr, uint8_t *dst, size_t len, bool nostop);
+
+#endif
@@ -0,0 +1,30 @@
+/*
+ * Project Name: Host stand-in for the RPI PICO SDK
+ * File: hardware/irq.h
+ * Description: stand-in header for host builds, handlers are called
+ * directly when a device model raises the event
+ * URL: https://github.com/gavinlyonsrepo/FM_Radio_PICO
+ */
+
+#ifndef HOST_HARDWARE_IRQ_h
+#define HOST_HARDWARE_IRQ_h
+
+#include <stdbool.h>
+#include <stdint.h>
+
+typedef void (*irq_handler_t)(void);
+
+#define DMA_IRQ_0     11
+#define IO_IRQ_BANK0  13
+#define I2C0_IRQ      23
+#define I2C1_IRQ      24
+
+#define PICO_SHARED_IRQ_HANDLER_DEFAULT_ORDER_PRIORITY 0x80
+
+void irq_set_enabled(unsigned int num, bool enabled);
+
+// Shared handlers are only raised for DMA_IRQ_0, by the stand-in DMA
+void irq_add_shared_handler(unsigned int num, irq_handler_t handler, uint8_t order_priority);
+void irq_remove_handler(unsigned int num, irq_handler_t handler);
+
+#endif
@@ -0,0 +1,38 @@
+/*
+ * Project Name: Host stand-in for the RPI PICO SDK
+ * File: hardware/spi.h
+ * Description: stand-in header for host builds, transfers go to a device
+ * model attached with host_spi_attach (see host_sim.hpp), by the CPU or DMA
+ * URL: https://github.com/gavinlyonsrepo/FM_Radio_PICO
+ */
+
+#ifndef HOST_HARDWARE_SPI_h
+#define HOST_HARDWARE_SPI_h
+
+#include "pico/stdlib.h"
+
+typedef struct spi_inst spi_inst_t;
+
+// Only the data register, the stand-in DMA uses its address to find the bus
+typedef struct {
+	volatile uint32_t dr;
+} spi_hw_t;
+
+extern spi_inst_t spi0_inst;
+extern spi_inst_t spi1_inst;
+#define spi0 (&spi0_inst)
+#define spi1 (&spi1_inst)
+
+typedef enum {SPI_CPOL_0 = 0, SPI_CPOL_1 = 1} spi_cpol_t;
+typedef enum {SPI_CPHA_0 = 0, SPI_CPHA_1 = 1} spi_cpha_t;
+typedef enum {SPI_LSB_FIRST = 0, SPI_MSB_FIRST = 1} spi_order_t;
+
+uint spi_init(spi_inst_t *spi, uint baudrate);
+void spi_deinit(spi_inst_t *spi);
+void spi_set_format(spi_inst_t *spi, uint data_bits, spi_cpol_t cpol, spi_cpha_t cpha, spi_order_t order);
+int spi_write_blocking(spi_inst_t *spi, const uint8_t *src, size_t len);
+bool spi_is_busy(const spi_inst_t *spi);
+spi_hw_t *spi_get_hw(spi_inst_t *spi);
+uint spi_get_dreq(spi_inst_t *spi, bool is_tx);
+
+#endif
@@ -0,0 +1,26 @@
+/*
+ * Project Name: Host stand-in for the RPI PICO SDK
+ * File: hardware/structs/sio.h
+ * Description: stand-in header for host builds, writes to the SIO set and
+ * clear registers change the in memory pins of hardware/gpio.h
+ * URL: https://github.com/gavinlyonsrepo/FM_Radio_PICO
+ */
+
+#ifndef HOST_HARDWARE_STRUCTS_SIO_h
+#define HOST_HARDWARE_STRUCTS_SIO_h
+
+#include <stdint.h>
+
+// Write only registers, assigning a mask drives those pins high or low
+struct HostSIOSet { void operator=(uint32_t mask); };
+struct HostSIOClr { void operator=(uint32_t mask); };
+
+typedef struct {
+	HostSIOSet gpio_set;
+	HostSIOClr gpio_clr;
+} sio_hw_t;
+
+extern sio_hw_t host_sio_hw;
+#define sio_hw (&host_sio_hw)
+
+#endif
@@ -0,0 +1,17 @@
+/*
+ * Project Name: Host stand-in for the RPI PICO SDK
+ * File: hardware/sync.h
+ * Description: stand-in header for host builds, single threaded so
+ * interrupt masking has nothing to do
+ * URL: https://github.com/gavinlyonsrepo/FM_Radio_PICO
+ */
+
+#ifndef HOST_HARDWARE_SYNC_h
+#define HOST_HARDWARE_SYNC_h
+
+#include <stdint.h>
+
+static inline uint32_t save_and_disable_interrupts(void) {return 0;}
+static inline void restore_interrupts(uint32_t) {}
+
+#endif
@@ -0,0 +1,69 @@
+/*
+ * Project Name: Host stand-in for the RPI PICO SDK
+ * File: host_sim.hpp
+ * Description: virtual clock with timed events, GPIO drive, I2C and SPI
+ * device attach, flash in memory and transfer statistics
+ * for the host build
+ * URL: https://github.com/gavinlyonsrepo/FM_Radio_PICO
+ */
+
+#ifndef HOST_SIM_h
+#define HOST_SIM_h
+
+#include "pico/stdlib.h"
+#include "hardware/i2c.h"
+#include "hardware/spi.h"
+
+// A device on a stand-in I2C bus
+class HostI2CDevice {
+	public:
+	  virtual ~HostI2CDevice() {}
+	  // Returns :: bytes accepted, or PICO_ERROR_GENERIC for a NACK
+	  virtual int write(const uint8_t *src, size_t len) = 0;
+	  // Returns :: bytes read, or PICO_ERROR_GENERIC for a NACK
+	  virtual int read(uint8_t *dst, size_t len) = 0;
+};
+
+// A device on a stand-in SPI bus, write only
+class HostSPIDevice {
+	public:
+	  virtual ~HostSPIDevice() {}
+	  virtual void write(const uint8_t *src, size_t len) = 0;
+};
+
+// Totals since the last host_sim_reset_stats
+struct HostSimStats
+{
+	uint32_t writes;          // I2C write transactions
+	uint32_t reads;           // I2C read transactions
+	uint32_t errors;          // transactions NACKed, no device
+	uint32_t bytesWritten;    // data bytes, address byte not counted
+	uint32_t bytesRead;
+	uint64_t busUs;           // time on the bus at the configured baud rate
+	uint64_t sleepUs;         // time in busy_wait / sleep calls
+	uint64_t cpuUs;           // time charged to time queries and poll loops
+	uint32_t flashErases;     // flash sectors erased
+	uint32_t flashPages;      // flash pages programmed
+	uint32_t spiWrites;       // SPI write calls
+	uint32_t spiBytes;        // SPI bytes written
+	uint64_t spiUs;           // time on the SPI bus at the configured baud rate
+};
+
+void host_i2c_attach(i2c_inst_t *i2c, uint8_t address, HostI2CDevice *device);
+void host_i2c_detach(i2c_inst_t *i2c, uint8_t address);
+
+void host_spi_attach(spi_inst_t *spi, HostSPIDevice *device);
+
+// Drive an input pin from a device model, edge interrupts are raised at once
+void host_gpio_drive(unsigned int gpio, bool level);
+
+// Call fn once the virtual clock reaches atUs, for device model timing
+typedef void (*HostSimEvent_t)(void *userData);
+bool host_sim_schedule(uint64_t atUs, HostSimEvent_t fn, void *userData);
+
+uint64_t host_sim_time_us(void);
+void host_sim_advance_us(uint64_t us);
+const HostSimStats& host_sim_stats(void);
+void host_sim_reset_stats(void);
+
+#endif
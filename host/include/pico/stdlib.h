@@ -0,0 +1,44 @@
+/*
+ * Project Name: Host stand-in for the RPI PICO SDK
+ * File: pico/stdlib.h
+ * Description: stand-in header for host builds, time runs on a virtual
+ * clock so timing of the drivers can be measured on a PC.
+ * URL: https://github.com/gavinlyonsrepo/FM_Radio_PICO
+ */
+
+#ifndef HOST_PICO_STDLIB_h
+#define HOST_PICO_STDLIB_h
+
+#include <stdio.h>
+#include <stdint.h>
+#include <stdbool.h>
+#include <stddef.h>
+
+typedef unsigned int uint;
+typedef uint64_t absolute_time_t;   // uS since boot on the virtual clock
+
+#define PICO_OK               0
+#define PICO_ERROR_TIMEOUT    -1
+#define PICO_ERROR_GENERIC    -2
+
+// Virtual time, each query costs 1 uS of CPU time so poll loops always advance
+absolute_time_t get_absolute_time(void);
+uint32_t to_ms_since_boot(absolute_time_t t);
+uint64_t to_us_since_boot(absolute_time_t t);
+absolute_time_t make_timeout_time_ms(uint32_t ms);
+absolute_time_t make_timeout_time_us(uint64_t us);
+bool time_reached(absolute_time_t t);
+int64_t absolute_time_diff_us(absolute_time_t from, absolute_time_t to);
+
+// Delays add to the sleep total of the host statistics
+void busy_wait_ms(uint32_t ms);
+void busy_wait_us(uint64_t us);
+void sleep_ms(uint32_t ms);
+void sleep_us(uint64_t us);
+void tight_loop_contents(void);
+
+bool stdio_init_all(void);
+
+#include "hardware/gpio.h"
+
+#endif
@@ -0,0 +1,81 @@
+/*
+ * Project Name: Host stand-in for the RPI PICO SDK
+ * File: tea5767_model.hpp
+ * Description: behavioural model of the TEA5767 on the stand-in I2C bus,
+ * PLL decode, search with stop levels, band limit, a synthetic station
+ * spectrum and ready timing on the virtual clock, SWPORT1 can drive a GPIO
+ * URL: https://github.com/gavinlyonsrepo/FM_Radio_PICO
+ */
+
+#ifndef TEA5767_MODEL_h
+#define TEA5767_MODEL_h
+
+#include "host_sim.hpp"
+
+#define TEA5767_MODEL_MAX_STATIONS    40
+#define TEA5767_MODEL_TUNE_US         5000    // uS preset tune until ready
+#define TEA5767_MODEL_STEP_US         2000    // uS per 100 kHz search step
+#define TEA5767_MODEL_WAKE_US         3000    // uS extra on the first tune out of standby
+#define TEA5767_MODEL_NOISE_LEVEL     2       // ADC level with no station
+#define TEA5767_MODEL_IMAGE_LOSS      4       // ADC levels of image rejection
+#define TEA5767_MODEL_STEREO_LEVEL    8       // lowest level decoded in stereo
+
+// One transmitter of the synthetic spectrum
+struct TEA5767ModelStation
+{
+	uint32_t kHz;
+	uint8_t level;     // ADC level 0-15 when tuned exactly
+	bool stereo;
+};
+
+class TEA5767Model : public HostI2CDevice {
+	public:
+	  TEA5767Model();
+
+	  void setStations(const TEA5767ModelStation *stations, uint8_t count);
+	  void setStationLevel(uint32_t kHz, uint8_t level);
+	  void setTiming(uint32_t tuneUs, uint32_t stepUs, uint32_t wakeUs = TEA5767_MODEL_WAKE_US);
+	  void setNoiseLevel(uint8_t level);
+	  void setNoiseRegion(uint32_t lowKHz, uint32_t highKHz, uint8_t level);
+	  void setSearchIndicatorPin(int8_t gpio);
+
+	  uint8_t levelAt(uint32_t kHz, bool hiSide) const;
+	  uint32_t getTunedKHz();
+	  bool isMuted() const;
+	  bool isStandby() const;
+	  bool isReady();
+
+	  int write(const uint8_t *src, size_t len) override;
+	  int read(uint8_t *dst, size_t len) override;
+
+	private:
+	  void startTune();
+	  void driveSwport1();
+	  static void readyEvent(void *userData);
+	  void update();
+	  bool stationFound(uint32_t kHz) const;
+	  uint8_t ifCounterAt(uint32_t kHz) const;
+	  uint32_t bandLow() const;
+	  uint32_t bandHigh() const;
+
+	  TEA5767ModelStation _stations[TEA5767_MODEL_MAX_STATIONS];
+	  uint8_t _stationCount = 0;
+	  uint32_t _tuneUs = TEA5767_MODEL_TUNE_US;
+	  uint32_t _stepUs = TEA5767_MODEL_STEP_US;
+	  uint32_t _wakeUs = TEA5767_MODEL_WAKE_US;
+	  uint8_t _noiseLevel = TEA5767_MODEL_NOISE_LEVEL;
+	  uint32_t _regionLowKHz = 0;   // raised noise region, see setNoiseRegion
+	  uint32_t _regionHighKHz = 0;
+	  uint8_t _regionLevel = 0;
+
+	  uint8_t _registers[5] = {0, 0, 0, 0, 0};
+	  uint32_t _startKHz = 0;       // frequency written
+	  uint32_t _resultKHz = 0;      // frequency once ready
+	  uint64_t _startUs = 0;        // virtual time of the write
+	  uint64_t _readyUs = 0;        // virtual time ready goes high
+	  bool _bandLimit = false;
+	  bool _searching = false;
+	  int8_t _swport1Pin = -1;      // GPIO driven by SWPORT1, -1 = not wired
+};
+
+#endif
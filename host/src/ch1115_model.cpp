@@ -0,0 +1,69 @@
+/*
+ * Project Name: Host stand-in for the RPI PICO SDK
+ * File: ch1115_model.cpp
+ * Description: model of the CH1115 OLED controller on the stand-in SPI bus
+ * URL: https://github.com/gavinlyonsrepo/FM_Radio_PICO
+ */
+
+#include <string.h>
+#include "ch1115_model.hpp"
+
+// Param1 :: cdPin , GPIO of the command/data line, low is command
+// Param2 :: csPin , GPIO of the chip select, bytes are ignored while high
+CH1115Model::CH1115Model(int8_t cdPin, int8_t csPin) : _cdPin(cdPin), _csPin(csPin) {}
+
+void CH1115Model::write(const uint8_t *src, size_t len) {
+	if (gpio_get(_csPin)) return;
+	bool isCommand = !gpio_get(_cdPin);
+	for (size_t i = 0; i < len; i++) {
+		if (isCommand) {
+			_commandBytes++;
+			command(src[i]);
+			continue;
+		}
+		_dataBytes++;
+		if (_column < CH1115_MODEL_WIDTH) _ram[_page * CH1115_MODEL_WIDTH + _column] = src[i];
+		_column++;
+	}
+}
+
+// Decode one command byte, only addressing changes the model state
+void CH1115Model::command(uint8_t byte) {
+	if (_argBytes > 0) {
+		_argBytes--;
+		return;
+	}
+	if (byte <= 0x0F) {
+		_column = (_column & 0xF0) | byte;
+	} else if (byte <= 0x1F) {
+		_column = (_column & 0x0F) | ((byte & 0x0F) << 4);
+	} else if (byte >= 0xB0 && byte <= 0xB7) {
+		_page = byte & 0x07;
+	} else {
+		switch (byte) {
+			case 0x23: case 0x81: case 0x82: case 0xA8: case 0xAD:
+			case 0xD3: case 0xD5: case 0xD9: case 0xDB:
+				_argBytes = 1; break;
+			case 0x24: _argBytes = 2; break;
+			case 0x26: case 0x27: _argBytes = 3; break;
+			default: break;
+		}
+	}
+}
+
+// Returns :: display RAM, page by page, 128 bytes a page
+const uint8_t *CH1115Model::getRAM() const {return _ram;}
+
+// Returns :: bool true if the display RAM equals a 128 x 64 frame buffer
+bool CH1115Model::matches(const uint8_t *buffer) const {
+	return memcmp(_ram, buffer, sizeof(_ram)) == 0;
+}
+
+uint32_t CH1115Model::getCommandBytes() const {return _commandBytes;}
+
+uint32_t CH1115Model::getDataBytes() const {return _dataBytes;}
+
+void CH1115Model::resetCounts() {
+	_commandBytes = 0;
+	_dataBytes = 0;
+}
@@ -0,0 +1,428 @@
+/*
+ * Project Name: Host stand-in for the RPI PICO SDK
+ * File: host_sim.cpp
+ * Description: virtual clock, stand-in GPIO, I2C, SPI, DMA and flash for the host build
+ * URL: https://github.com/gavinlyonsrepo/FM_Radio_PICO
+ */
+
+#include <string.h>
+#include "host_sim.hpp"
+#include "hardware/flash.h"
+#include "hardware/dma.h"
+
+#define HOST_GPIO_COUNT       30
+#define HOST_I2C_ADDRESSES    128
+#define HOST_I2C_BITS_PER_BYTE 9     // 8 data bits and ACK
+#define HOST_I2C_FRAME_BITS   2     // start and stop
+#define HOST_EVENT_COUNT      8     // pending timed events
+#define HOST_IRQ_HANDLERS     4     // raw GPIO handlers, shared DMA handlers
+#define HOST_DMA_CHANNELS     4
+#define HOST_SPI_CALL_US      1     // CPU time per blocking SPI call, FIFO drain and busy wait
+
+struct i2c_inst
+{
+	uint baudrate;
+	HostI2CDevice *devices[HOST_I2C_ADDRESSES];
+};
+
+i2c_inst_t i2c0_inst = {};
+i2c_inst_t i2c1_inst = {};
+
+struct spi_inst
+{
+	spi_hw_t hw;
+	uint baudrate;
+	HostSPIDevice *device;
+	uint64_t busyUntilUs;   // last byte out, DMA transfers
+};
+
+spi_inst_t spi0_inst = {};
+spi_inst_t spi1_inst = {};
+
+static uint64_t hostTimeUs = 0;
+static HostSimStats hostStats = {};
+static bool hostGpio[HOST_GPIO_COUNT] = {};
+static uint32_t hostGpioIrqEnabled[HOST_GPIO_COUNT] = {};
+static uint32_t hostGpioIrqEvents[HOST_GPIO_COUNT] = {};
+static irq_handler_t hostIrqHandlers[HOST_IRQ_HANDLERS] = {};
+
+struct HostEvent
+{
+	uint64_t atUs;
+	HostSimEvent_t fn;
+	void *userData;
+};
+static HostEvent hostEvents[HOST_EVENT_COUNT] = {};
+
+// === Virtual clock ===
+
+uint64_t host_sim_time_us(void) {return hostTimeUs;}
+
+// Move the clock on, running each timed event at its own time
+void host_sim_advance_us(uint64_t us) {
+	uint64_t target = hostTimeUs + us;
+	while (true) {
+		int8_t next = -1;
+		for (uint8_t i = 0; i < HOST_EVENT_COUNT; i++) {
+			if (hostEvents[i].fn != nullptr && hostEvents[i].atUs <= target &&
+				(next < 0 || hostEvents[i].atUs < hostEvents[next].atUs))
+				next = i;
+		}
+		if (next < 0) break;
+		HostEvent event = hostEvents[next];
+		hostEvents[next].fn = nullptr;
+		if (event.atUs > hostTimeUs) hostTimeUs = event.atUs;
+		event.fn(event.userData);
+	}
+	if (target > hostTimeUs) hostTimeUs = target; // an event may have moved it on further
+}
+
+// Returns :: bool false if the event table is full
+// Notes :: A pending event with the same fn and userData is moved, not added
+bool host_sim_schedule(uint64_t atUs, HostSimEvent_t fn, void *userData) {
+	for (uint8_t i = 0; i < HOST_EVENT_COUNT; i++) {
+		if (hostEvents[i].fn == fn && hostEvents[i].userData == userData) {
+			hostEvents[i].atUs = atUs;
+			return true;
+		}
+	}
+	for (uint8_t i = 0; i < HOST_EVENT_COUNT; i++) {
+		if (hostEvents[i].fn == nullptr) {
+			hostEvents[i] = {atUs, fn, userData};
+			return true;
+		}
+	}
+	return false;
+}
+
+const HostSimStats& host_sim_stats(void) {return hostStats;}
+
+void host_sim_reset_stats(void) {hostStats = {};}
+
+absolute_time_t get_absolute_time(void) {
+	host_sim_advance_us(1);
+	hostStats.cpuUs++;
+	return hostTimeUs;
+}
+
+uint32_t to_ms_since_boot(absolute_time_t t) {return (uint32_t)(t / 1000);}
+
+uint64_t to_us_since_boot(absolute_time_t t) {return t;}
+
+absolute_time_t make_timeout_time_ms(uint32_t ms) {return hostTimeUs + (uint64_t)ms * 1000;}
+
+absolute_time_t make_timeout_time_us(uint64_t us) {return hostTimeUs + us;}
+
+bool time_reached(absolute_time_t t) {return get_absolute_time() >= t;}
+
+int64_t absolute_time_diff_us(absolute_time_t from, absolute_time_t to) {return (int64_t)(to - from);}
+
+void busy_wait_us(uint64_t us) {
+	host_sim_advance_us(us);
+	hostStats.sleepUs += us;
+}
+
+void busy_wait_ms(uint32_t ms) {busy_wait_us((uint64_t)ms * 1000);}
+
+void sleep_us(uint64_t us) {busy_wait_us(us);}
+
+void sleep_ms(uint32_t ms) {busy_wait_ms(ms);}
+
+void tight_loop_contents(void) {
+	host_sim_advance_us(1);
+	hostStats.cpuUs++;
+}
+
+bool stdio_init_all(void) {return true;}
+
+// === GPIO ===
+
+void gpio_init(unsigned int gpio) {if (gpio < HOST_GPIO_COUNT) hostGpio[gpio] = false;}
+
+void gpio_set_function(unsigned int, enum gpio_function) {}
+
+void gpio_set_dir(unsigned int, bool) {}
+
+void gpio_put(unsigned int gpio, bool value) {if (gpio < HOST_GPIO_COUNT) hostGpio[gpio] = value;}
+
+bool gpio_get(unsigned int gpio) {return (gpio < HOST_GPIO_COUNT) ? hostGpio[gpio] : false;}
+
+sio_hw_t host_sio_hw;
+
+void HostSIOSet::operator=(uint32_t mask) {
+	for (unsigned int gpio = 0; gpio < HOST_GPIO_COUNT; gpio++) if (mask & (1ul << gpio)) hostGpio[gpio] = true;
+}
+
+void HostSIOClr::operator=(uint32_t mask) {
+	for (unsigned int gpio = 0; gpio < HOST_GPIO_COUNT; gpio++) if (mask & (1ul << gpio)) hostGpio[gpio] = false;
+}
+
+void gpio_pull_up(unsigned int) {}
+
+void gpio_pull_down(unsigned int) {}
+
+void gpio_set_irq_enabled(unsigned int gpio, uint32_t events, bool enabled) {
+	if (gpio >= HOST_GPIO_COUNT) return;
+	if (enabled) hostGpioIrqEnabled[gpio] |= events;
+	else hostGpioIrqEnabled[gpio] &= ~events;
+}
+
+void gpio_add_raw_irq_handler_masked(uint32_t, irq_handler_t handler) {
+	for (uint8_t i = 0; i < HOST_IRQ_HANDLERS; i++) {
+		if (hostIrqHandlers[i] == nullptr || hostIrqHandlers[i] == handler) {
+			hostIrqHandlers[i] = handler;
+			return;
+		}
+	}
+}
+
+void gpio_remove_raw_irq_handler_masked(uint32_t, irq_handler_t handler) {
+	for (uint8_t i = 0; i < HOST_IRQ_HANDLERS; i++) {
+		if (hostIrqHandlers[i] == handler) hostIrqHandlers[i] = nullptr;
+	}
+}
+
+uint32_t gpio_get_irq_event_mask(unsigned int gpio) {
+	return (gpio < HOST_GPIO_COUNT) ? hostGpioIrqEvents[gpio] : 0;
+}
+
+void gpio_acknowledge_irq(unsigned int gpio, uint32_t events) {
+	if (gpio < HOST_GPIO_COUNT) hostGpioIrqEvents[gpio] &= ~events;
+}
+
+void irq_set_enabled(unsigned int, bool) {}
+
+void host_gpio_drive(unsigned int gpio, bool level) {
+	if (gpio >= HOST_GPIO_COUNT || hostGpio[gpio] == level) return;
+	hostGpio[gpio] = level;
+	uint32_t events = (level ? GPIO_IRQ_EDGE_RISE : GPIO_IRQ_EDGE_FALL) & hostGpioIrqEnabled[gpio];
+	if (events == 0) return;
+	hostGpioIrqEvents[gpio] |= events;
+	for (uint8_t i = 0; i < HOST_IRQ_HANDLERS; i++) {
+		if (hostIrqHandlers[i] != nullptr) hostIrqHandlers[i]();
+	}
+}
+
+// === I2C ===
+
+void host_i2c_attach(i2c_inst_t *i2c, uint8_t address, HostI2CDevice *device) {
+	i2c->devices[address & 0x7F] = device;
+}
+
+void host_i2c_detach(i2c_inst_t *i2c, uint8_t address) {
+	i2c->devices[address & 0x7F] = nullptr;
+}
+
+uint i2c_init(i2c_inst_t *i2c, uint baudrate) {
+	i2c->baudrate = baudrate;
+	return baudrate;
+}
+
+void i2c_deinit(i2c_inst_t *i2c) {i2c->baudrate = 0;}
+
+// Charge the bus time of one transaction, address byte included
+static void hostI2CBusTime(i2c_inst_t *i2c, size_t len) {
+	uint baudrate = (i2c->baudrate != 0) ? i2c->baudrate : 100000;
+	uint64_t bits = (len + 1) * HOST_I2C_BITS_PER_BYTE + HOST_I2C_FRAME_BITS;
+	uint64_t us = (bits * 1000000 + baudrate - 1) / baudrate;
+	host_sim_advance_us(us);
+	hostStats.busUs += us;
+}
+
+int i2c_write_timeout_us(i2c_inst_t *i2c, uint8_t addr, const uint8_t *src, size_t len, bool, uint) {
+	HostI2CDevice *device = i2c->devices[addr & 0x7F];
+	hostStats.writes++;
+	if (device == nullptr) {
+		hostI2CBusTime(i2c, 0);
+		hostStats.errors++;
+		return PICO_ERROR_GENERIC;
+	}
+	int result = device->write(src, len);
+	hostI2CBusTime(i2c, (result > 0) ? result : 0);
+	if (result < 0) hostStats.errors++;
+	else hostStats.bytesWritten += result;
+	return result;
+}
+
+int i2c_read_timeout_us(i2c_inst_t *i2c, uint8_t addr, uint8_t *dst, size_t len, bool, uint) {
+	HostI2CDevice *device = i2c->devices[addr & 0x7F];
+	hostStats.reads++;
+	if (device == nullptr) {
+		hostI2CBusTime(i2c, 0);
+		hostStats.errors++;
+		return PICO_ERROR_GENERIC;
+	}
+	int result = device->read(dst, len);
+	hostI2CBusTime(i2c, (result > 0) ? result : 0);
+	if (result < 0) hostStats.errors++;
+	else hostStats.bytesRead += result;
+	return result;
+}
+
+int i2c_write_blocking(i2c_inst_t *i2c, uint8_t addr, const uint8_t *src, size_t len, bool nostop) {
+	return i2c_write_timeout_us(i2c, addr, src, len, nostop, 0);
+}
+
+int i2c_read_blocking(i2c_inst_t *i2c, uint8_t addr, uint8_t *dst, size_t len, bool nostop) {
+	return i2c_read_timeout_us(i2c, addr, dst, len, nostop, 0);
+}
+
+// === SPI ===
+
+void host_spi_attach(spi_inst_t *spi, HostSPIDevice *device) {spi->device = device;}
+
+uint spi_init(spi_inst_t *spi, uint baudrate) {
+	spi->baudrate = baudrate;
+	return baudrate;
+}
+
+void spi_deinit(spi_inst_t *spi) {spi->baudrate = 0;}
+
+void spi_set_format(spi_inst_t *, uint, spi_cpol_t, spi_cpha_t, spi_order_t) {}
+
+// Bus time is 8 clocks a byte, back to back
+static uint64_t hostSPIBusTime(spi_inst_t *spi, size_t len) {
+	uint baudrate = (spi->baudrate != 0) ? spi->baudrate : 1000000;
+	uint64_t us = ((uint64_t)len * 8 * 1000000 + baudrate - 1) / baudrate;
+	hostStats.spiWrites++;
+	hostStats.spiBytes += len;
+	hostStats.spiUs += us;
+	return us;
+}
+
+// Waits for a DMA transfer still shifting out first
+int spi_write_blocking(spi_inst_t *spi, const uint8_t *src, size_t len) {
+	if (spi->busyUntilUs > hostTimeUs) host_sim_advance_us(spi->busyUntilUs - hostTimeUs);
+	uint64_t us = hostSPIBusTime(spi, len);
+	if (spi->device != nullptr) spi->device->write(src, len);
+	host_sim_advance_us(us + HOST_SPI_CALL_US);
+	hostStats.cpuUs += HOST_SPI_CALL_US;
+	return (int)len;
+}
+
+bool spi_is_busy(const spi_inst_t *spi) {return spi->busyUntilUs > hostTimeUs;}
+
+spi_hw_t *spi_get_hw(spi_inst_t *spi) {return &spi->hw;}
+
+uint spi_get_dreq(spi_inst_t *spi, bool is_tx) {return (spi == spi0 ? 16 : 18) + (is_tx ? 0 : 1);}
+
+// === DMA ===
+
+struct HostDMAChannel
+{
+	bool claimed;
+	dma_channel_config config;
+	volatile void *writeAddr;
+	bool busy;
+	bool irq0Enabled;
+	bool irq0Status;
+};
+static HostDMAChannel hostDMA[HOST_DMA_CHANNELS] = {};
+static irq_handler_t hostDMAHandlers[HOST_IRQ_HANDLERS] = {};
+
+void irq_add_shared_handler(unsigned int num, irq_handler_t handler, uint8_t) {
+	if (num != DMA_IRQ_0) return;
+	for (uint8_t i = 0; i < HOST_IRQ_HANDLERS; i++) {
+		if (hostDMAHandlers[i] == nullptr || hostDMAHandlers[i] == handler) {
+			hostDMAHandlers[i] = handler;
+			return;
+		}
+	}
+}
+
+void irq_remove_handler(unsigned int num, irq_handler_t handler) {
+	if (num != DMA_IRQ_0) return;
+	for (uint8_t i = 0; i < HOST_IRQ_HANDLERS; i++) {
+		if (hostDMAHandlers[i] == handler) hostDMAHandlers[i] = nullptr;
+	}
+}
+
+int dma_claim_unused_channel(bool) {
+	for (uint8_t i = 0; i < HOST_DMA_CHANNELS; i++) {
+		if (!hostDMA[i].claimed) {
+			hostDMA[i] = {};
+			hostDMA[i].claimed = true;
+			return i;
+		}
+	}
+	return -1;
+}
+
+void dma_channel_unclaim(uint channel) {if (channel < HOST_DMA_CHANNELS) hostDMA[channel].claimed = false;}
+
+dma_channel_config dma_channel_get_default_config(uint) {return {DMA_SIZE_32, true, false, 0x3f};}
+
+void channel_config_set_transfer_data_size(dma_channel_config *c, enum dma_channel_transfer_size size) {c->size = size;}
+
+void channel_config_set_read_increment(dma_channel_config *c, bool incr) {c->readIncrement = incr;}
+
+void channel_config_set_write_increment(dma_channel_config *c, bool incr) {c->writeIncrement = incr;}
+
+void channel_config_set_dreq(dma_channel_config *c, uint dreq) {c->dreq = dreq;}
+
+// Transfer complete, raise DMA_IRQ_0
+static void hostDMADone(void *userData) {
+	HostDMAChannel *channel = (HostDMAChannel *)userData;
+	channel->busy = false;
+	if (!channel->irq0Enabled) return;
+	channel->irq0Status = true;
+	for (uint8_t i = 0; i < HOST_IRQ_HANDLERS; i++) {
+		if (hostDMAHandlers[i] != nullptr) hostDMAHandlers[i]();
+	}
+}
+
+// Byte transfers to an SPI data register only, other transfers complete at once
+static void hostDMAStart(uint channel, const volatile void *readAddr, uint32_t count) {
+	HostDMAChannel &dma = hostDMA[channel];
+	uint64_t us = 0;
+	dma.busy = true;
+	spi_inst_t *buses[] = {spi0, spi1};
+	for (spi_inst_t *spi : buses) {
+		if (dma.writeAddr != &spi->hw.dr || dma.config.size != DMA_SIZE_8) continue;
+		if (spi->busyUntilUs > hostTimeUs) us = spi->busyUntilUs - hostTimeUs;
+		us += hostSPIBusTime(spi, count);
+		if (spi->device != nullptr) spi->device->write((const uint8_t *)readAddr, count);
+		spi->busyUntilUs = hostTimeUs + us;
+	}
+	host_sim_schedule(hostTimeUs + us, hostDMADone, &dma);
+}
+
+void dma_channel_configure(uint channel, const dma_channel_config *config, volatile void *write_addr,
+	const volatile void *read_addr, uint transfer_count, bool trigger) {
+	if (channel >= HOST_DMA_CHANNELS) return;
+	hostDMA[channel].config = *config;
+	hostDMA[channel].writeAddr = write_addr;
+	if (trigger) hostDMAStart(channel, read_addr, transfer_count);
+}
+
+void dma_channel_transfer_from_buffer_now(uint channel, const volatile void *read_addr, uint32_t transfer_count) {
+	if (channel < HOST_DMA_CHANNELS) hostDMAStart(channel, read_addr, transfer_count);
+}
+
+bool dma_channel_is_busy(uint channel) {return channel < HOST_DMA_CHANNELS && hostDMA[channel].busy;}
+
+void dma_channel_set_irq0_enabled(uint channel, bool enabled) {
+	if (channel < HOST_DMA_CHANNELS) hostDMA[channel].irq0Enabled = enabled;
+}
+
+bool dma_channel_get_irq0_status(uint channel) {return channel < HOST_DMA_CHANNELS && hostDMA[channel].irq0Status;}
+
+void dma_channel_acknowledge_irq0(uint channel) {
+	if (channel < HOST_DMA_CHANNELS) hostDMA[channel].irq0Status = false;
+}
+
+// Flash, erased state is all ones and programming can only clear bits
+uint8_t host_flash[PICO_FLASH_SIZE_BYTES];
+static bool hostFlashErased = [] {memset(host_flash, 0xFF, sizeof(host_flash)); return true;}();
+
+void flash_range_erase(uint32_t flash_offs, size_t count) {
+	if (flash_offs % FLASH_SECTOR_SIZE || count % FLASH_SECTOR_SIZE || flash_offs + count > PICO_FLASH_SIZE_BYTES) return;
+	memset(host_flash + flash_offs, 0xFF, count);
+	hostStats.flashErases += count / FLASH_SECTOR_SIZE;
+}
+
+void flash_range_program(uint32_t flash_offs, const uint8_t *data, size_t count) {
+	if (flash_offs % FLASH_PAGE_SIZE || count % FLASH_PAGE_SIZE || flash_offs + count > PICO_FLASH_SIZE_BYTES) return;
+	for (size_t i = 0; i < count; i++) host_flash[flash_offs + i] &= data[i];
+	hostStats.flashPages += count / FLASH_PAGE_SIZE;
+}
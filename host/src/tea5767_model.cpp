@@ -0,0 +1,228 @@
+/*
+ * Project Name: Host stand-in for the RPI PICO SDK
+ * File: tea5767_model.cpp
+ * Description: behavioural model of the TEA5767 on the stand-in I2C bus
+ * URL: https://github.com/gavinlyonsrepo/FM_Radio_PICO
+ */
+
+#include <string.h>
+#include "tea5767_model.hpp"
+
+#define MODEL_IF_HZ          225000
+#define MODEL_PLL_STEP_HZ    8192     // 32.768 kHz crystal / 4
+#define MODEL_SEARCH_KHZ     100
+
+// Constructor, empty spectrum, registers at power on
+TEA5767Model::TEA5767Model() {}
+
+// Set the synthetic spectrum
+// Param1 :: stations , array of transmitters
+// Param2 :: count , up to TEA5767_MODEL_MAX_STATIONS
+void TEA5767Model::setStations(const TEA5767ModelStation *stations, uint8_t count) {
+	if (count > TEA5767_MODEL_MAX_STATIONS) count = TEA5767_MODEL_MAX_STATIONS;
+	memcpy(_stations, stations, count * sizeof(TEA5767ModelStation));
+	_stationCount = count;
+}
+
+// Change the level of one transmitter, e.g. fading while driving between sites
+// Param1 :: kHz , Param2 :: level , ADC level when tuned exactly
+void TEA5767Model::setStationLevel(uint32_t kHz, uint8_t level) {
+	for (uint8_t i = 0; i < _stationCount; i++) {
+		if (_stations[i].kHz == kHz) _stations[i].level = level;
+	}
+}
+
+// Set the ready timing
+// Param1 :: tuneUs , preset tune time until ready
+// Param2 :: stepUs , search time per 100 kHz step
+// Param3 :: wakeUs , extra time for the first tune out of standby
+void TEA5767Model::setTiming(uint32_t tuneUs, uint32_t stepUs, uint32_t wakeUs) {
+	_tuneUs = tuneUs;
+	_stepUs = stepUs;
+	_wakeUs = wakeUs;
+}
+
+// Param1 :: level , ADC level read with no station
+void TEA5767Model::setNoiseLevel(uint8_t level) {_noiseLevel = level;}
+
+// Raise the noise over part of the band, e.g. interference near a transmitter site
+// Param1 :: lowKHz , Param2 :: highKHz , region edges
+// Param3 :: level , ADC level, alternate 100 kHz channels read one higher, 0 = no region
+void TEA5767Model::setNoiseRegion(uint32_t lowKHz, uint32_t highKHz, uint8_t level) {
+	_regionLowKHz = lowKHz;
+	_regionHighKHz = highKHz;
+	_regionLevel = level;
+}
+
+// Wire SWPORT1 to a stand-in GPIO
+// Param1 :: gpio , -1 = not wired
+// Notes :: With SI set SWPORT1 is the ready flag, high when ready, else the SWP1 bit.
+void TEA5767Model::setSearchIndicatorPin(int8_t gpio) {
+	_swport1Pin = gpio;
+	driveSwport1();
+}
+
+// Set the SWPORT1 pin from the registers and ready state
+void TEA5767Model::driveSwport1() {
+	if (_swport1Pin < 0) return;
+	if (_registers[3] & 0x01)
+		host_gpio_drive(_swport1Pin, isReady());
+	else
+		host_gpio_drive(_swport1Pin, _registers[2] & 0x01);
+}
+
+// Timed event at ready, a later write may have moved ready on so the state is checked again
+void TEA5767Model::readyEvent(void *userData) {
+	((TEA5767Model *)userData)->driveSwport1();
+}
+
+// Signal level the ADC reports at a frequency
+// Param1 :: kHz , tuned RF frequency
+// Param2 :: hiSide , injection side, the image is 450 kHz above on high side, below on low side
+// Returns :: uint8_t level 0-15
+// Notes :: A station drops 2 levels per 50 kHz off tune, rounded. The image is
+// rejected by TEA5767_MODEL_IMAGE_LOSS levels.
+uint8_t TEA5767Model::levelAt(uint32_t kHz, bool hiSide) const {
+	uint32_t imageKHz = hiSide ? kHz + 2 * (MODEL_IF_HZ / 1000) : kHz - 2 * (MODEL_IF_HZ / 1000);
+	int16_t level = _noiseLevel;
+	uint32_t channelKHz = ((kHz + 25) / 50) * 50; // region is on the 50 kHz raster, not the PLL
+	if (_regionLevel > 0 && channelKHz >= _regionLowKHz && channelKHz <= _regionHighKHz)
+		level = _regionLevel + ((channelKHz / 100) & 1);
+	for (uint8_t i = 0; i < _stationCount; i++) {
+		int32_t distance = (int32_t)_stations[i].kHz - (int32_t)kHz;
+		if (distance < 0) distance = -distance;
+		int16_t signal = (int16_t)_stations[i].level - (int16_t)((distance + 12) / 25);
+		if (signal > level) level = signal;
+
+		distance = (int32_t)_stations[i].kHz - (int32_t)imageKHz;
+		if (distance < 0) distance = -distance;
+		signal = (int16_t)_stations[i].level - (int16_t)((distance + 12) / 25) - TEA5767_MODEL_IMAGE_LOSS;
+		if (signal > level) level = signal;
+	}
+	return (level > 15) ? 15 : (uint8_t)level;
+}
+
+// IF counter at a frequency, nominal count when on a station, off by the tuning error
+uint8_t TEA5767Model::ifCounterAt(uint32_t kHz) const {
+	int32_t nearest = -1;
+	int32_t offsetHz = 0;
+	for (uint8_t i = 0; i < _stationCount; i++) {
+		int32_t distance = ((int32_t)_stations[i].kHz - (int32_t)kHz) * 1000;
+		int32_t magnitude = (distance < 0) ? -distance : distance;
+		if (magnitude <= 150000 && (nearest < 0 || magnitude < nearest)) {
+			nearest = magnitude;
+			offsetHz = distance;
+		}
+	}
+	if (nearest < 0) return (uint8_t)((kHz * 37) % 128); // no carrier, counter wanders
+	int32_t count = (MODEL_IF_HZ + offsetHz) / 4096;
+	if (count < 0) count = 0;
+	return (count > 127) ? 127 : (uint8_t)count;
+}
+
+// Returns :: bool true if search would stop at the frequency, level at the stop level
+// Notes :: As the chip the IF counter is not checked, so a strong station also
+// stops the search a step either side of it, see TEA5767N_T::setSeekVerify
+bool TEA5767Model::stationFound(uint32_t kHz) const {
+	static const uint8_t stopLevel[4] = {5, 5, 7, 10};
+	bool hiSide = (_registers[2] >> 4) & 1;
+	return levelAt(kHz, hiSide) >= stopLevel[(_registers[2] >> 5) & 0x03];
+}
+
+uint32_t TEA5767Model::bandLow() const {return ((_registers[3] >> 5) & 1) ? 76000 : 87500;}
+
+uint32_t TEA5767Model::bandHigh() const {return ((_registers[3] >> 5) & 1) ? 91000 : 108000;}
+
+// Work out the result of a write, preset tune or search
+// Notes :: Search checks the written frequency then steps 100 kHz in the
+// search direction until a stop or the band limit, one step per stepUs.
+// Stops outside the band are skipped, the limit is only hit moving past it.
+void TEA5767Model::startTune() {
+	bool hiSide = (_registers[2] >> 4) & 1;
+	uint32_t pll = ((_registers[0] & 0x3F) << 8) | _registers[1];
+	uint32_t rfHz = hiSide ? pll * MODEL_PLL_STEP_HZ - MODEL_IF_HZ : pll * MODEL_PLL_STEP_HZ + MODEL_IF_HZ;
+
+	_startKHz = (rfHz + 500) / 1000;
+	_startUs = host_sim_time_us();
+	_bandLimit = false;
+	_searching = (_registers[0] >> 6) & 1;
+	_resultKHz = _startKHz;
+	_readyUs = _startUs + _tuneUs;
+	if (!_searching) return;
+
+	bool up = (_registers[2] >> 7) & 1;
+	uint32_t steps = 0;
+	uint32_t kHz = _startKHz;
+	while (true) {
+		if ((up && kHz > bandHigh()) || (!up && kHz < bandLow())) {
+			_bandLimit = true;
+			kHz = up ? bandHigh() : bandLow();
+			break;
+		}
+		if (kHz >= bandLow() && kHz <= bandHigh() && stationFound(kHz)) break;
+		kHz = up ? kHz + MODEL_SEARCH_KHZ : kHz - MODEL_SEARCH_KHZ;
+		steps++;
+	}
+	_resultKHz = kHz;
+	_readyUs = _startUs + _tuneUs + (uint64_t)steps * _stepUs;
+}
+
+// Search is complete when ready is reached
+void TEA5767Model::update() {
+	if (_searching && host_sim_time_us() >= _readyUs) _searching = false;
+}
+
+// Returns :: uint32_t frequency the model is tuned to now, kHz
+uint32_t TEA5767Model::getTunedKHz() {
+	update();
+	if (!_searching) return _resultKHz;
+	uint64_t steps = (host_sim_time_us() - _startUs) / _stepUs;
+	bool up = (_registers[2] >> 7) & 1;
+	return up ? _startKHz + steps * MODEL_SEARCH_KHZ : _startKHz - steps * MODEL_SEARCH_KHZ;
+}
+
+bool TEA5767Model::isMuted() const {return (_registers[0] >> 7) & 1;}
+
+bool TEA5767Model::isStandby() const {return (_registers[3] >> 6) & 1;}
+
+bool TEA5767Model::isReady() {return !isStandby() && host_sim_time_us() >= _readyUs;}
+
+// I2C write, bytes are taken in register order, a short write keeps the rest
+int TEA5767Model::write(const uint8_t *src, size_t len) {
+	if (len == 0) return PICO_ERROR_GENERIC;
+	if (len > 5) len = 5;
+	bool waking = isStandby();
+	memcpy(_registers, src, len);
+	startTune();
+	if (waking && !isStandby()) _readyUs += _wakeUs;
+	driveSwport1();
+	if (_swport1Pin >= 0 && (_registers[3] & 0x01)) host_sim_schedule(_readyUs, readyEvent, this);
+	return (int)len;
+}
+
+// I2C read, up to five status bytes
+int TEA5767Model::read(uint8_t *dst, size_t len) {
+	uint8_t data[5] = {0, 0, 0, 0, 0};
+	bool hiSide = (_registers[2] >> 4) & 1;
+	uint32_t kHz = getTunedKHz();
+	uint32_t pll = (hiSide ? kHz * 1000 + MODEL_IF_HZ : kHz * 1000 - MODEL_IF_HZ) + MODEL_PLL_STEP_HZ / 2;
+	pll /= MODEL_PLL_STEP_HZ;
+
+	if (len == 0) return PICO_ERROR_GENERIC;
+	if (len > 5) len = 5;
+	if (!isStandby()) {
+		uint8_t level = levelAt(kHz, hiSide);
+		bool stereo = false;
+		for (uint8_t i = 0; i < _stationCount; i++) {
+			int32_t distance = (int32_t)_stations[i].kHz - (int32_t)kHz;
+			if (distance >= -50 && distance <= 50 && _stations[i].stereo) stereo = true;
+		}
+		stereo = stereo && !((_registers[2] >> 3) & 1) && level >= TEA5767_MODEL_STEREO_LEVEL;
+		data[0] = (isReady() ? 0x80 : 0) | ((isReady() && _bandLimit) ? 0x40 : 0) | ((pll >> 8) & 0x3F);
+		data[1] = pll & 0xFF;
+		data[2] = (stereo ? 0x80 : 0) | ifCounterAt(kHz);
+		data[3] = level << 4;
+	}
+	memcpy(dst, data, len);
+	return (int)len;
+}
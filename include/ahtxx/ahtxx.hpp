@@ -14,6 +14,8 @@
 #include <stdbool.h>
 #include "pico/stdlib.h"
 #include "hardware/i2c.h"
+#include "i2casync/i2c_async.hpp"
+#include "i2cbus/i2c_bus.hpp"
 
 #define AHT10_ADDRESS_0X38         0x38  // I2C address no.1 for AHT10/AHT15/AHT20, adres pin connect to GND
 #define AHT10_ADDRESS_0X39         0x39  // I2C address no.2 for AHT10 only, adres pin connect to Vcc
@@ -49,22 +51,41 @@ typedef enum ASAIR_I2C_SENSOR_e{
     AHT20_SENSOR = 0x02
 }ASAIR_I2C_SENSOR_e;
 
-class LIB_AHTXX
+typedef enum AHT10_MeasureState_e{
+	AHT10_MEASURE_IDLE = 0,     // no measurement running
+	AHT10_MEASURE_TRIGGER,      // measurement command queued
+	AHT10_MEASURE_WAIT,         // sensor converting, waiting measurement delay
+	AHT10_MEASURE_READ,         // 6 byte read queued
+	AHT10_MEASURE_DONE,         // data in buffer, read with AHT10_USE_READ_DATA
+	AHT10_MEASURE_ERROR         // I2C error or calibration off
+}AHT10_MeasureState_e;
+
+// Sensor driver templated on the I2C bus backend, see i2cbus/i2c_bus.hpp
+template <class Bus>
+class LIB_AHTXX_T
 {
 private:
-    i2c_inst_t *i2c = i2c0;
+    Bus bus;  // I2C bus backend
     uint8_t  _address;
     ASAIR_I2C_SENSOR_e _sensorName;
     uint8_t  _rawDataBuffer[6] = {AHT10_ERROR, 0, 0, 0, 0, 0};
     int16_t  returnValue = 0;
     bool isConnected = false;
 
+    // Asynchronous I2C transport, optional
+    I2CAsync *_asyncBus = nullptr;
+    I2CAsyncTransfer _asyncTransfer;
+    uint8_t _asyncTxBuffer[3];
+    AHT10_MeasureState_e _measureState = AHT10_MEASURE_IDLE;
+    absolute_time_t _measureDeadline;
+
 public:
     // Constructor
-    LIB_AHTXX(uint8_t , ASAIR_I2C_SENSOR_e);
+    LIB_AHTXX_T(uint8_t , ASAIR_I2C_SENSOR_e);
 
     void     AHT10_InitI2C(i2c_inst_t* i2c_type,  uint8_t sdata , uint8_t sclk ,uint16_t clockspeed);
-    void     AHT10_DeInit(i2c_inst_t* i2c_type);
+    void     AHT10_DeInit();
+    Bus&     AHT10_GetBus();
     bool     AHT10_begin();
     uint8_t  AHT10_readRawData();
     float    AHT10_readTemperature(bool);
@@ -78,8 +99,15 @@ public:
     bool     AHT10_enableFactoryCalCoeff();
     uint8_t  AHT10_getBusyBit(bool);
 
+    void AHT10_SetAsyncBus(I2CAsync *);
+    bool AHT10_StartMeasurement(void);
+    AHT10_MeasureState_e AHT10_PollMeasurement(void);
+
     void AHT10_SetIsConnected(bool);
     bool AHT10_GetIsConnected(void);
 };
+
+typedef LIB_AHTXX_T<I2CHardwareBus> LIB_AHTXX;
+
 #endif
 
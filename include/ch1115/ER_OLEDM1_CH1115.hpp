@@ -13,6 +13,7 @@
 
 #include "ch1115/ER_OLEDM1_CH1115_graphics.hpp"
 #include "hardware/spi.h"
+#include "hardware/structs/sio.h"
 
 // ** DEFINES **
 
@@ -76,23 +77,28 @@
 #define ERMCH1115_DEACTIVATE_SCROLL  0x2E
 #define ERMCH1115_ACTIVATE_SCROLL   0x2F
 
-// GPIO
-#define ERMCH1115_CS_SetHigh gpio_put(_OLED_CS, true)
-#define ERMCH1115_CS_SetLow gpio_put(_OLED_CS, false)
-#define ERMCH1115_CD_SetHigh gpio_put(_OLED_CD, true)
-#define ERMCH1115_CD_SetLow gpio_put(_OLED_CD, false)
-#define ERMCH1115_RST_SetHigh gpio_put(_OLED_RST, true)
-#define ERMCH1115_RST_SetLow gpio_put(_OLED_RST, false)
-#define ERMCH1115_SCLK_SetHigh gpio_put(_OLED_SCLK, true) 
-#define ERMCH1115_SCLK_SetLow  gpio_put(_OLED_SCLK, false) 
-#define ERMCH1115_SDA_SetHigh gpio_put(_OLED_DIN, true)
-#define ERMCH1115_SDA_SetLow  gpio_put(_OLED_DIN, false)
+// GPIO, direct SIO set and clear register writes
+#define ERMCH1115_CS_SetHigh sio_hw->gpio_set = (1ul << _OLED_CS)
+#define ERMCH1115_CS_SetLow sio_hw->gpio_clr = (1ul << _OLED_CS)
+#define ERMCH1115_CD_SetHigh sio_hw->gpio_set = (1ul << _OLED_CD)
+#define ERMCH1115_CD_SetLow sio_hw->gpio_clr = (1ul << _OLED_CD)
+#define ERMCH1115_RST_SetHigh sio_hw->gpio_set = (1ul << _OLED_RST)
+#define ERMCH1115_RST_SetLow sio_hw->gpio_clr = (1ul << _OLED_RST)
+#define ERMCH1115_SCLK_SetHigh sio_hw->gpio_set = (1ul << _OLED_SCLK) 
+#define ERMCH1115_SCLK_SetLow  sio_hw->gpio_clr = (1ul << _OLED_SCLK) 
+#define ERMCH1115_SDA_SetHigh sio_hw->gpio_set = (1ul << _OLED_DIN)
+#define ERMCH1115_SDA_SetLow  sio_hw->gpio_clr = (1ul << _OLED_DIN)
 
 // Delays
 #define ERMCH1115_INITDELAY 100 // mS
 #define ERMCH1115_RST_DELAY1 10 // mS
 #define ERMCH1115_RST_DELAY2 100 // mS         
 
+// Partial update
+#define ERMCH1115_SPAN_GAP 3 // unchanged bytes sent inside a span, cheaper than 3 address commands
+#define ERMCH1115_PAGE_SPANS 4 // spans per page, the last is extended once full
+#define ERMCH1115_SPAN_MAX 32 // spans per update, 8 pages * ERMCH1115_PAGE_SPANS
+
 // ** GLOBALS **
 
 // Display  Size
@@ -100,6 +106,24 @@ const uint8_t OLED_WIDTH = 128;
 const uint8_t OLED_HEIGHT = 64;
 const uint8_t OLED_PAGE_NUM = (OLED_HEIGHT/8);
 
+// Columns of one page sent by an update
+struct ERMCH1115_Span_t
+{
+	uint8_t page;
+	uint8_t colStart;
+	uint8_t colEnd;
+};
+
+// Update statistics, blocking and DMA updates
+struct ERMCH1115_FrameStats_t
+{
+	uint32_t frames;      // updates completed
+	uint32_t spans;       // spans sent by the last update
+	uint32_t bytes;       // data bytes sent by the last update
+	uint32_t lastFrameUs; // last update, start to last byte out
+	uint32_t maxFrameUs;  // longest update
+};
+
 // ** CLASS SECTION **
 class ERMCH1115 : public ERMCH1115_graphics  {
 
@@ -109,8 +133,20 @@ class ERMCH1115 : public ERMCH1115_graphics  {
 	~ERMCH1115(){};
 
 	virtual void drawPixel(int16_t x, int16_t y, uint8_t colour) override;
+	virtual void drawFastVLine(int16_t x, int16_t y, int16_t h, uint8_t colour) override;
+	virtual void drawFastHLine(int16_t x, int16_t y, int16_t w, uint8_t colour) override;
+	virtual void fillRect(int16_t x, int16_t y, int16_t w, int16_t h, uint8_t colour) override;
+	virtual void drawChar(int16_t x, int16_t y, unsigned char c, uint8_t colour, uint8_t bg, uint8_t size) override;
 	void OLEDupdate(void);
 	void OLEDclearBuffer(void);
+	void OLEDmarkDirty(void);
+
+	bool OLEDbeginAsync(void);
+	bool OLEDupdateAsync(void);
+	bool OLEDIsBusy(void);
+	void OLEDwaitAsync(void);
+	const ERMCH1115_FrameStats_t& OLEDgetFrameStats(void);
+	void dmaIrqHandler(void);
 	void OLEDBuffer(int16_t x, int16_t y, uint8_t w, uint8_t h, uint8_t* data);
 	
 	void OLEDbegin(uint8_t OLEDcontrast = ERMCH115_CONTRAST_DATA_DEFAULT, spi_inst_t *spi = spi0, uint32_t spiBaudRate = 8000);
@@ -138,7 +174,16 @@ class ERMCH1115 : public ERMCH1115_graphics  {
   private:
 
 	void send_data(uint8_t data);
+	void send_data(const uint8_t* data, size_t length);
 	void send_command(uint8_t command, uint8_t value);
+	void send_commands(const uint8_t* commands, uint8_t length);
+	void send_address(uint8_t page, uint8_t column);
+	void markDirty(uint8_t page, uint8_t colStart, uint8_t colEnd);
+	uint8_t collectSpans(void);
+	void sendSpan(const ERMCH1115_Span_t &span);
+	void startSpan(void);
+	void frameDone(void);
+	void screenChanged(uint8_t pages);
 
 	int8_t _OLED_CS;
 	int8_t _OLED_CD;
@@ -149,6 +194,23 @@ class ERMCH1115 : public ERMCH1115_graphics  {
 	bool _sleep = true; // False awake/ON , true sleep/OFF
 	uint8_t _OLEDcontrast; // Contrast default 0x80 datasheet 00-FF
 	spi_inst_t *spi = spi0;
+
+	// Partial update, pages drawn on since the last OLEDupdate and the column
+	// range drawn on in each, a copy of the display RAM trims it to changed bytes
+	uint8_t _dirtyPages = 0; // bit per page
+	uint8_t _dirtyStart[OLED_PAGE_NUM] = {}; // first column drawn on
+	uint8_t _dirtyEnd[OLED_PAGE_NUM] = {}; // last column drawn on
+	uint8_t _screenKnown = 0; // bit per page, display RAM matches _screen
+	uint8_t _screen[OLED_WIDTH * OLED_PAGE_NUM]; // display RAM as last sent, the DMA source
+	ERMCH1115_Span_t _spans[ERMCH1115_SPAN_MAX]; // spans of the update being sent
+	uint8_t _spanCount = 0;
+
+	// DMA update, spans are sent from _screen while drawing goes on in OLEDbuffer
+	int _dmaChannel = -1; // -1 not set up
+	volatile uint8_t _spanNext = 0; // next span to start
+	volatile bool _asyncBusy = false; // DMA update in flight
+	uint64_t _frameStartUs = 0;
+	ERMCH1115_FrameStats_t _frameStats = {0, 0, 0, 0, 0};
 }; // end of class
 
 #endif // end of guard header
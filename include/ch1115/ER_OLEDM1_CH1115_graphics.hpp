@@ -60,10 +60,10 @@ class ERMCH1115_graphics : public Print {
 	virtual void drawPixel(int16_t x, int16_t y, uint8_t color)  = 0;
 
 	void drawLine(int16_t x0, int16_t y0, int16_t x1, int16_t y1, uint8_t color);
-	void drawFastVLine(int16_t x, int16_t y, int16_t h, uint8_t color);
-	void drawFastHLine(int16_t x, int16_t y, int16_t w, uint8_t color);
+	virtual void drawFastVLine(int16_t x, int16_t y, int16_t h, uint8_t color);
+	virtual void drawFastHLine(int16_t x, int16_t y, int16_t w, uint8_t color);
 	void drawRect(int16_t x, int16_t y, int16_t w, int16_t h, uint8_t color);
-	void fillRect(int16_t x, int16_t y, int16_t w, int16_t h, uint8_t color);
+	virtual void fillRect(int16_t x, int16_t y, int16_t w, int16_t h, uint8_t color);
 	void fillScreen(uint8_t color);
 
 	void drawCircle(int16_t x0, int16_t y0, int16_t r, uint8_t color);
@@ -82,7 +82,7 @@ class ERMCH1115_graphics : public Print {
 		int16_t radius, uint8_t color);
 	void	drawBitmap(int16_t x, int16_t y, const uint8_t *bitmap,
 			int16_t w, int16_t h, uint8_t color, uint8_t bg);
-	void drawChar(int16_t x, int16_t y, unsigned char c, uint8_t color,
+	virtual void drawChar(int16_t x, int16_t y, unsigned char c, uint8_t color,
 		uint8_t bg, uint8_t size);
 	void setCursor(int16_t x, int16_t y);
 	void setTextColor(uint8_t c);
@@ -120,6 +120,7 @@ class ERMCH1115_graphics : public Print {
 	uint8_t _CurrentFontWidth = OLEDFontWidth_5;
 	uint8_t _CurrentFontoffset = OLEDFontOffset_Extend ;
 	uint8_t _CurrentFontheight = OLEDFontHeight_8;
+	const unsigned char * _CurrentFont = nullptr; // glyph data of fonts 1-6, set by setFontNum
 };
 
 #endif 
@@ -0,0 +1,49 @@
+/*
+ * Project Name: Flash record store for RPI PICO
+ * File: flash_store.hpp
+ * Description: library header file, keeps one small settings record per
+ * flash sector at the top of the PICO flash, checked by magic and checksum.
+ * Toolchain :: Rpi PICO ,rp2040, SDK C++
+ * URL: https://github.com/gavinlyonsrepo/FM_Radio_PICO
+ */
+
+#ifndef FLASH_STORE_h
+#define FLASH_STORE_h
+
+#include "pico/stdlib.h"
+#include "hardware/flash.h"
+
+// Sectors counted back from the end of flash, one record each, well clear of the program
+#define FLASH_STORE_SECTOR_NOISE      1     // TEA5767 noise floor profile
+#define FLASH_STORE_SECTOR_SKIP       2     // TEA5767 skipped channels
+#define FLASH_STORE_SECTOR_PRESETS    3     // TEA5767 station presets
+
+// Header written in front of the record
+struct FlashStoreHeader
+{
+	uint32_t magic;       // record type and version, chosen by the user of the store
+	uint16_t length;      // record bytes after the header
+	uint16_t checksum;    // Fletcher-16 of the record bytes
+};
+
+#define FLASH_STORE_MAX_LENGTH        (FLASH_SECTOR_SIZE - sizeof(FlashStoreHeader))
+
+class FlashStore {
+	public:
+	  FlashStore(uint8_t sector, uint32_t magic);
+
+	  bool load(void *data, uint16_t length);
+	  bool save(const void *data, uint16_t length);
+	  void erase();
+	  bool isValid(uint16_t length);
+	  uint32_t getOffset();
+
+	private:
+	  const uint8_t *record();
+	  static uint16_t checksum(const uint8_t *data, uint16_t length);
+
+	  uint32_t _offset;     // byte offset of the sector from the start of flash
+	  uint32_t _magic;
+};
+
+#endif
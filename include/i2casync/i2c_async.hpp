@@ -0,0 +1,95 @@
+/*
+ * Project Name: Asynchronous I2C transport for RPI PICO
+ * File: i2c_async.hpp
+ * Description: library header file, queues I2C transfers per bus and
+ * runs them from the I2C interrupt so the CPU is free while bytes move.
+ * Toolchain :: Rpi PICO ,rp2040, SDK C++
+ * URL: https://github.com/gavinlyonsrepo/FM_Radio_PICO
+ */
+
+#ifndef I2C_ASYNC_h
+#define I2C_ASYNC_h
+
+#include <stdio.h>
+#include "pico/stdlib.h"
+#include "hardware/i2c.h"
+
+// Define I2C_ASYNC_HOST to build the polled backend, transfers are run one at
+// a time from poll() using the blocking SDK calls. Used for host side testing
+// with stand-in SDK headers, and works on the PICO as a fallback.
+
+#define I2C_ASYNC_QUEUE_SIZE          8     // transfers queued per bus
+#define I2C_ASYNC_MAX_LENGTH          16    // bytes per transfer, size of the I2C FIFO
+#define I2C_ASYNC_HOST_TIMEOUT        50000 // uS I2C timeout, polled backend
+#define I2C_ASYNC_ABORT_TIMEOUT       1000  // uS for the controller to abort a cancelled transfer
+
+typedef enum
+{
+	I2C_ASYNC_IDLE = 0,     // not submitted
+	I2C_ASYNC_QUEUED,       // waiting for the bus
+	I2C_ASYNC_BUSY,         // on the bus
+	I2C_ASYNC_DONE,         // completed OK
+	I2C_ASYNC_ERROR         // aborted e.g. address NACK, or queue full
+}I2CAsyncStatus_e;
+
+struct I2CAsyncTransfer;
+
+// Completion callback, called from the I2C interrupt (from poll() on the polled
+// backend) so keep it short.
+typedef void (*I2CAsyncCallback_t)(I2CAsyncTransfer *transfer, void *userData);
+
+// One transfer, owned by the caller and polled as a future via status
+struct I2CAsyncTransfer
+{
+	uint8_t address;                      // 7 bit device address
+	bool read;                            // true read, false write
+	uint8_t *data;                        // read destination or write source
+	uint8_t length;                       // bytes, 1 to I2C_ASYNC_MAX_LENGTH
+	I2CAsyncCallback_t callback;          // optional
+	void *userData;                       // passed to callback
+	volatile I2CAsyncStatus_e status = I2C_ASYNC_IDLE;
+	volatile uint8_t issued;              // commands pushed to the FIFO
+	volatile uint8_t received;            // bytes read from the FIFO
+
+	// Returns :: bool true once the transfer has completed or failed
+	bool isFinished() const {return status == I2C_ASYNC_DONE || status == I2C_ASYNC_ERROR;}
+	// Returns :: bool true while queued or on the bus
+	bool isPending() const {return status == I2C_ASYNC_QUEUED || status == I2C_ASYNC_BUSY;}
+};
+
+class I2CAsync {
+	public:
+	  I2CAsync(i2c_inst_t *i2c);
+
+	  void begin();
+	  void end();
+
+	  bool submitWrite(I2CAsyncTransfer &transfer, uint8_t address, uint8_t *data, uint8_t length,
+		I2CAsyncCallback_t callback = nullptr, void *userData = nullptr);
+	  bool submitRead(I2CAsyncTransfer &transfer, uint8_t address, uint8_t *data, uint8_t length,
+		I2CAsyncCallback_t callback = nullptr, void *userData = nullptr);
+	  bool wait(I2CAsyncTransfer &transfer, uint32_t timeoutUs);
+	  void cancel(I2CAsyncTransfer &transfer);
+	  void flush();
+	  void poll();
+	  bool isBusy();
+	  i2c_inst_t *getInstance();
+
+	  void irqHandler();
+
+	private:
+	  bool submit(I2CAsyncTransfer &transfer);
+	  void startNext();
+	  void finish(I2CAsyncStatus_e result);
+	  void fillFifo();
+
+	  i2c_inst_t *_i2c;
+	  I2CAsyncTransfer * volatile _queue[I2C_ASYNC_QUEUE_SIZE];
+	  volatile uint8_t _head = 0;            // next transfer to run
+	  volatile uint8_t _tail = 0;            // next free slot
+	  I2CAsyncTransfer * volatile _active = nullptr;
+	  volatile bool _aborted = false;        // TX abort seen on the active transfer
+	  bool _started = false;
+};
+
+#endif
@@ -0,0 +1,112 @@
+/*
+ * Project Name: I2C bus backends for RPI PICO
+ * File: i2c_bus.hpp
+ * Description: library header file, bus backends the device drivers are
+ * templated on. Each backend has the same members, resolved at compile time:
+ *   void init(i2c_inst_t *i2c, uint8_t sdata, uint8_t sclk, uint16_t clockspeed);
+ *   void deinit();
+ *   int  write(uint8_t address, const uint8_t *src, size_t len, uint32_t timeoutUs);
+ *   int  read(uint8_t address, uint8_t *dst, size_t len, uint32_t timeoutUs);
+ * write and read return the bytes moved, less than zero on error, as the SDK.
+ * Toolchain :: Rpi PICO ,rp2040, SDK C++
+ * URL: https://github.com/gavinlyonsrepo/FM_Radio_PICO
+ */
+
+#ifndef I2C_BUS_h
+#define I2C_BUS_h
+
+#include <stdio.h>
+#include "pico/stdlib.h"
+#include "hardware/i2c.h"
+#include "i2casync/i2c_async.hpp"
+
+#define I2C_BITBANG_DEFAULT_KHZ   100   // bit-bang clock if none given
+#define I2C_MOCK_LOG_SIZE         16    // bytes of the last write kept by the mock
+
+// Hardware I2C block, blocking SDK calls
+class I2CHardwareBus {
+	public:
+	  void init(i2c_inst_t *i2c, uint8_t sdata, uint8_t sclk, uint16_t clockspeed);
+	  void deinit();
+	  int write(uint8_t address, const uint8_t *src, size_t len, uint32_t timeoutUs);
+	  int read(uint8_t address, uint8_t *dst, size_t len, uint32_t timeoutUs);
+	  i2c_inst_t *getInstance();
+
+	private:
+	  i2c_inst_t *_i2c = i2c0;
+};
+
+// Hardware I2C block through an I2CAsync transfer queue
+// Blocking calls queue behind any asynchronous transfers on the same bus
+// instead of flushing them, so drivers can share the queue. The timeout covers
+// the wait in the queue and on the bus, on expiry the transfer is cancelled.
+class I2CAsyncBus {
+	public:
+	  void setQueue(I2CAsync *queue);
+	  void init(i2c_inst_t *i2c, uint8_t sdata, uint8_t sclk, uint16_t clockspeed);
+	  void deinit();
+	  int write(uint8_t address, const uint8_t *src, size_t len, uint32_t timeoutUs);
+	  int read(uint8_t address, uint8_t *dst, size_t len, uint32_t timeoutUs);
+	  I2CAsync *getQueue();
+
+	private:
+	  int transfer(I2CAsyncTransfer &transfer, size_t len, uint32_t timeoutUs);
+	  I2CAsync *_queue = nullptr;
+};
+
+// Software I2C on any two GPIO, open drain by switching pin direction
+// i2c in init is unused, pass nullptr. Clock stretching is honoured up to the timeout.
+class I2CBitBangBus {
+	public:
+	  void init(i2c_inst_t *i2c, uint8_t sdata, uint8_t sclk, uint16_t clockspeed);
+	  void deinit();
+	  int write(uint8_t address, const uint8_t *src, size_t len, uint32_t timeoutUs);
+	  int read(uint8_t address, uint8_t *dst, size_t len, uint32_t timeoutUs);
+
+	private:
+	  void sdaRelease();
+	  void sdaLow();
+	  bool sclRelease();
+	  void sclLow();
+	  bool start();
+	  void stop();
+	  bool writeByte(uint8_t data);
+	  bool readByte(uint8_t &data, bool ack);
+
+	  uint8_t _sda = 0;
+	  uint8_t _scl = 0;
+	  uint32_t _halfPeriodUs = 5;
+	  absolute_time_t _deadline;
+};
+
+// Called by the mock for each transfer
+// Returns :: bytes moved, less than zero for a NACK
+typedef int (*I2CMockHandler_t)(void *userData, uint8_t address, bool read, uint8_t *data, size_t len);
+
+// No hardware, transfers are counted and passed to an optional handler.
+// Without a handler writes are accepted and reads return zeros.
+class I2CMockBus {
+	public:
+	  void setHandler(I2CMockHandler_t handler, void *userData);
+	  void init(i2c_inst_t *i2c, uint8_t sdata, uint8_t sclk, uint16_t clockspeed);
+	  void deinit();
+	  int write(uint8_t address, const uint8_t *src, size_t len, uint32_t timeoutUs);
+	  int read(uint8_t address, uint8_t *dst, size_t len, uint32_t timeoutUs);
+
+	  uint32_t getWrites();
+	  uint32_t getReads();
+	  uint32_t getBytes();
+	  const uint8_t *getLastWrite(size_t &len);
+	  void resetCounts();
+
+	private:
+	  I2CMockHandler_t _handler = nullptr;
+	  void *_userData = nullptr;
+	  uint32_t _writes = 0;
+	  uint32_t _reads = 0;
+	  uint32_t _bytes = 0;
+	  uint8_t _lastWrite[I2C_MOCK_LOG_SIZE];
+	  size_t _lastWriteLen = 0;
+};
+
+#endif
@@ -15,6 +15,8 @@
 #include <stdio.h> // optional for printf debug messages
 #include "pico/stdlib.h"
 #include "hardware/i2c.h"
+#include "i2casync/i2c_async.hpp"
+#include "i2cbus/i2c_bus.hpp"
 
 #define TEA5767_I2C_ADDRESS           0x60
 #define TEA5767_I2C_DELAY             50000 // uS I2C timeout
@@ -63,28 +65,321 @@
 #define SEARCH_INDICATOR_ON           1
 #define SEARCH_INDICATOR_OFF          0
 
-class TEA5767N {
+// Asynchronous seek timing
+#define TEA5767_SEEK_SETTLE_MS        10    // mS, wait after a register write in the seek
+#define TEA5767_SEEK_POLL_MS          10    // mS, interval between ready flag reads
+#define TEA5767_SEEK_TIMEOUT_MS       3000  // mS, give up waiting for ready flag
+
+// Verified seek, a hardware stop is only accepted on a real carrier
+#define TEA5767_VERIFY_IF_LOW         0x31  // IF counter window for correct tuning, datasheet
+#define TEA5767_VERIFY_IF_HIGH        0x3E
+#define TEA5767_VERIFY_MIN_LEVEL      6     // ADC level a verified stop needs
+#define TEA5767_VERIFY_MAX_STOPS      24    // false stops passed before giving up
+
+// Chip search bands, the BL bit selects the Japan band for a search below the split
+#define TEA5767_BAND_SPLIT_KHZ        87500 // kHz, US/Europe band 87.5 - 108 MHz above
+#define TEA5767_BAND_JAPAN_HIGH_KHZ   91000 // kHz, Japan band 76 - 91 MHz with BL set
+
+// Noise floor profile, per band segment stop level and acceptance threshold
+#define TEA5767_NOISE_SEGMENT_KHZ     1000  // kHz per segment
+#define TEA5767_NOISE_SEGMENTS        32    // segments from TEA5767_TABLE_START_KHZ, 76 to 108 MHz
+#define TEA5767_NOISE_MARGIN          2     // ADC levels above the floor a stop needs
+
+// SWPORT1 as ready flag output (SI bit) wired to a GPIO interrupt
+#define TEA5767_READY_PIN_NONE        -1
+#define TEA5767_READY_PIN_COUNT       30    // RP2040 bank 0 GPIO
+
+// Integer frequency, all tuning is done in kHz so no floating point is needed
+#define TEA5767_IF_KHZ                225     // kHz, intermediate frequency
+#define TEA5767_CHANNEL_KHZ           50      // kHz, channel spacing of the PLL table
+#define TEA5767_TABLE_START_KHZ       76000   // kHz, lowest channel (Japan band start)
+#define TEA5767_TABLE_END_KHZ         108000  // kHz, highest channel
+#define TEA5767_CHANNEL_COUNT         (((TEA5767_TABLE_END_KHZ - TEA5767_TABLE_START_KHZ) / TEA5767_CHANNEL_KHZ) + 1)
+
+// PLL word for a frequency, N = 4 * (RF +/- IF) / 32768 Hz = (kHz +/- 225) * 125 / 1024
+// Param1 :: kHz , Param2 :: true high side injection, false low side
+// Returns :: PLL word rounded to nearest
+constexpr uint16_t TEA5767_PLLWord(uint32_t kHz, bool hiSide)
+{
+	return (uint16_t)((((hiSide ? kHz + TEA5767_IF_KHZ : kHz - TEA5767_IF_KHZ) * 125UL) + 512) >> 10);
+}
+
+// Frequency in kHz of a PLL word, rounded to the nearest 50 kHz channel
+// Param1 :: PLL word , Param2 :: true high side injection, false low side
+constexpr uint32_t TEA5767_PLLToKHz(uint16_t pllWord, bool hiSide)
+{
+	return ((((uint32_t)pllWord * 8192UL) + (hiSide ? 0UL : 2UL * TEA5767_IF_KHZ * 1000UL)
+		- TEA5767_IF_KHZ * 1000UL + (TEA5767_CHANNEL_KHZ * 500UL)) / (TEA5767_CHANNEL_KHZ * 1000UL)) * TEA5767_CHANNEL_KHZ;
+}
+
+// Channel index of the PLL table for a frequency, -1 if off the 50 kHz raster or out of band
+constexpr int16_t TEA5767_Channel(uint32_t kHz)
+{
+	return (kHz < TEA5767_TABLE_START_KHZ || kHz > TEA5767_TABLE_END_KHZ ||
+		((kHz - TEA5767_TABLE_START_KHZ) % TEA5767_CHANNEL_KHZ) != 0) ? -1 :
+		(int16_t)((kHz - TEA5767_TABLE_START_KHZ) / TEA5767_CHANNEL_KHZ);
+}
+
+// Frequency in kHz of a PLL table channel index
+constexpr uint32_t TEA5767_ChannelToKHz(uint16_t channel)
+{
+	return TEA5767_TABLE_START_KHZ + ((uint32_t)channel * TEA5767_CHANNEL_KHZ);
+}
+
+// Nearest PLL table channel index for any in band frequency, -1 if out of band
+constexpr int16_t TEA5767_NearestChannel(uint32_t kHz)
+{
+	return (kHz < TEA5767_TABLE_START_KHZ || kHz > TEA5767_TABLE_END_KHZ) ? -1 :
+		(int16_t)((kHz - TEA5767_TABLE_START_KHZ + (TEA5767_CHANNEL_KHZ / 2)) / TEA5767_CHANNEL_KHZ);
+}
+
+// Band plans, see setBandPlan()
+typedef enum
+{
+	TEA5767_BAND_EUROPE = 0,      // 87.5 - 108 MHz, 100 kHz raster
+	TEA5767_BAND_US,              // 87.9 - 107.9 MHz, odd 200 kHz channels
+	TEA5767_BAND_JAPAN,           // 76 - 95 MHz, 100 kHz raster
+	TEA5767_BAND_PLAN_COUNT
+}TEA5767_BandPlan_e;
+
+// Legal channels of a band plan are lowKHz + n * rasterKHz up to highKHz
+struct TEA5767_BandPlan_t
+{
+	uint32_t lowKHz;      // first channel
+	uint32_t highKHz;     // last channel
+	uint16_t rasterKHz;   // channel spacing
+	const char *name;     // short name for the display
+};
+
+constexpr TEA5767_BandPlan_t TEA5767_bandPlans[TEA5767_BAND_PLAN_COUNT] =
+{
+	{87500, 108000, 100, "EU"},
+	{87900, 107900, 200, "US"},
+	{76000, 95000, 100, "JP"},
+};
+
+// Legal channel of a band plan at or beyond a frequency
+// Param1 :: plan , Param2 :: kHz , Param3 :: true the channel at or above, false at or below
+// Returns :: kHz of the channel, below the first channel this is lowKHz or one raster under it
+constexpr uint32_t TEA5767_SnapChannel(const TEA5767_BandPlan_t &plan, uint32_t kHz, bool up)
+{
+	return (kHz <= plan.lowKHz) ? ((up || kHz == plan.lowKHz) ? plan.lowKHz : plan.lowKHz - plan.rasterKHz) :
+		(((kHz - plan.lowKHz) % plan.rasterKHz) == 0) ? kHz :
+		kHz - ((kHz - plan.lowKHz) % plan.rasterKHz) + (up ? plan.rasterKHz : 0);
+}
+
+// Next legal channel of a band plan past a frequency in a direction
+// Returns :: kHz , may be outside the band, the caller checks the band edges
+constexpr uint32_t TEA5767_NextChannel(const TEA5767_BandPlan_t &plan, uint32_t kHz, bool up)
+{
+	return TEA5767_SnapChannel(plan, up ? kHz + 1 : kHz - 1, up);
+}
+
+// Hi/Lo injection cache
+#define TEA5767_INJECTION_CACHE_SIZE  32      // entries, direct mapped by channel
+#define TEA5767_INJECTION_MAX_AGE_MS  600000  // mS, default age before a channel is probed again
+#define TEA5767_INJECTION_LEVEL_DROP  4       // default level drop that invalidates an entry
+#define TEA5767_INJECTION_NO_LEVEL    0xFF    // entry level not yet read
+
+// One entry of the injection cache
+struct TEA5767_InjectionEntry_t
+{
+	int16_t channel;      // PLL table channel index, -1 = empty
+	uint8_t hiInjection;  // 1 high side, 0 low side
+	uint8_t level;        // level when tuned, TEA5767_INJECTION_NO_LEVEL until read
+	uint32_t timeStamp;   // mS since boot of the probe
+};
+
+// Status snapshot freshness
+#define TEA5767_STATUS_MAX_AGE_MS     250   // mS, default age before status is read again
+
+// Settle after a register write, chosen by what the write changed
+#define TEA5767_SETTLE_SHORT_MS       10    // mS, mute and option changes
+#define TEA5767_SETTLE_POLL_MS        2     // mS, ready flag poll interval after a retune
+#define TEA5767_SETTLE_TIMEOUT_MS     100   // mS, deadline for the ready flag after a retune
+
+typedef enum
+{
+	TEA5767_SETTLE_NONE = 0,      // pure reads, nothing to settle
+	TEA5767_SETTLE_SHORT,         // mute, stereo, noise and other option bits
+	TEA5767_SETTLE_READY          // PLL, injection side, band or crystal, poll ready flag
+}TEA5767_Settle_e;
+
+// How long the module took to settle, ready flag policy
+struct TEA5767_SettleStats_t
+{
+	uint32_t count;       // retunes waited for
+	uint32_t timeouts;    // ready flag not seen before the deadline
+	uint32_t lastUs;      // last settle time
+	uint32_t minUs;
+	uint32_t maxUs;
+	uint64_t totalUs;
+	uint32_t shortCount;  // option changes given the short settle
+};
+
+// Noise floor of each band segment, 16 bytes so it can be kept in flash
+// Notes :: Two 4 bit ADC levels per byte, low nibble even segment.
+// A floor of 0 is an uncalibrated segment, the fixed stop level is used there.
+struct TEA5767_NoiseProfile_t
+{
+	uint8_t floor[TEA5767_NOISE_SEGMENTS / 2];
+};
+
+// Channels the seeks pass over, one bit per PLL table channel, 81 bytes so it can be kept in flash
+// Notes :: Bit (channel & 7) of byte (channel / 8), set = skipped. All zero skips nothing.
+struct TEA5767_SkipList_t
+{
+	uint8_t bits[(TEA5767_CHANNEL_COUNT + 7) / 8];
+};
+
+// Tuning captured on entry to standby, written back in one go by resume()
+struct TEA5767_StandbyState_t
+{
+	uint8_t data[5];      // transmission bytes, PLL word, injection side and options
+	uint32_t frequency;   // kHz
+	uint8_t hiInjection;  // 1 high side, 0 low side
+	bool muted;
+	bool valid;           // false until standby() captures
+};
+
+// Decoded status bytes, filled by one 5 byte read of the module
+struct RadioStatus
+{
+	bool ready;           // RF , station found or band limit reached
+	bool bandLimit;       // BLF , band limit reached
+	uint16_t pllWord;     // PLL[13:0] , tuned or found PLL word
+	bool stereo;          // STEREO , stereo reception
+	uint8_t ifCounter;    // IF[6:0] , IF counter result
+	uint8_t level;        // LEV[3:0] , ADC signal level
+	uint8_t chipID;       // CI[3:1] , chip identification, 0
+	uint32_t timeStamp;   // mS since boot of the read
+};
+
+// States of the asynchronous seek, see seekStart() and seekPoll()
+typedef enum
+{
+	TEA5767_SEEK_IDLE = 0,        // no seek in progress
+	TEA5767_SEEK_MUTE,            // mute audio (muting seek only)
+	TEA5767_SEEK_START,           // step off current station and set search mode
+	TEA5767_SEEK_WAIT_READY,      // read status to poll ready flag
+	TEA5767_SEEK_CHECK_READY,     // check ready flag, station or band limit found
+	TEA5767_SEEK_BAND_LIMIT,      // read band limit flag
+	TEA5767_SEEK_LOAD_FREQ,       // load found frequency, search mode off
+	TEA5767_SEEK_UNMUTE,          // restore audio (muting seek only)
+	TEA5767_SEEK_COMPLETE         // done, callback called on next poll
+}TEA5767_SeekState_e;
+
+// Called when an asynchronous seek completes
+// Param1 :: band limit reached flag , Param2 :: user data passed to seekStart
+typedef void (*TEA5767_SeekCallback_t)(uint8_t bandLimitReached, void *userData);
+
+// Radio driver templated on the I2C bus backend, see i2cbus/i2c_bus.hpp
+// Instantiated in tea5767.cpp for the hardware, async, bit-bang and mock backends.
+template <class Bus>
+class TEA5767N_T {
 	private:
 	  bool bdebug = false; // If true debug information printed
 	  bool isConnected = false;
-	  i2c_inst_t * i2c = i2c1;  // i2C port number
+	  Bus bus;  // I2C bus backend
 	  uint8_t _i2cAddress;
 
-	  float frequency;
+	  uint32_t frequency;  // kHz
 	  uint8_t hiInjection;
+	  TEA5767_InjectionEntry_t injectionCache[TEA5767_INJECTION_CACHE_SIZE];
+	  uint32_t injectionMaxAge = TEA5767_INJECTION_MAX_AGE_MS;
+	  uint8_t injectionLevelDrop = TEA5767_INJECTION_LEVEL_DROP;
+	  bool probing = false;           // true during calculateOptimalHiLoInjection
+	  uint32_t injectionProbes = 0;   // statistics
+	  uint32_t injectionHits = 0;
 	  uint8_t frequencyH;
 	  uint8_t frequencyL;
 	  uint8_t transmission_data[5];
+	  uint8_t transmitted_data[5];   // copy of the last bytes written to the module
+	  bool transmittedValid = false; // false until first successful write
+	  uint8_t transactionDepth = 0;  // nesting level of beginTransaction()
+	  bool transmissionDirty = false;// transmission_data changed inside a transaction
 	  uint8_t reception_data[5];
+	  RadioStatus status;             // decoded copy of reception_data
+	  bool statusValid = false;       // false if status is stale due to a retune
+	  uint32_t statusMaxAge = TEA5767_STATUS_MAX_AGE_MS;
 	  bool muted;
+
+	  // Settle policy after register writes
+	  uint16_t settleShortMs = TEA5767_SETTLE_SHORT_MS;
+	  uint16_t settlePollMs = TEA5767_SETTLE_POLL_MS;
+	  uint16_t settleTimeoutMs = TEA5767_SETTLE_TIMEOUT_MS;
+	  bool settling = false;          // true while polling the ready flag
+	  TEA5767_SettleStats_t settleStats = {0, 0, 0, 0xFFFFFFFF, 0, 0, 0};
+
+	  // Noise floor profile, optional
+	  const TEA5767_NoiseProfile_t *noiseProfile = nullptr;
+	  uint8_t noiseMargin = TEA5767_NOISE_MARGIN;
+	  uint8_t seekStopBits = 0;       // SSL bits set by the user, restored after the seek
+	  uint32_t seekFromKHz = 0;       // kHz the chip search last started from
+
+	  // Skipped channels, optional
+	  TEA5767_SkipList_t *skipList = nullptr;
+	  uint32_t seekSkippedStops = 0;  // statistics
+
+	  // Band plan, channel raster, seek start points and wrap at the band edges
+	  TEA5767_BandPlan_e bandPlan = TEA5767_BAND_EUROPE;
+	  bool seekWrap = false;          // wrap to the other band edge at a band limit
+	  bool seekWrapped = false;       // this seek has wrapped once
+
+	  // Standby with preserved tuning
+	  TEA5767_StandbyState_t standbyState = {{0, 0, 0, 0, 0}, 0, 1, false, false};
+	  uint32_t wakeLatencyUs = 0;     // last resume, write to ready flag
+
+	  // SWPORT1 ready flag interrupt, optional
+	  int8_t readyPin = TEA5767_READY_PIN_NONE;
+	  volatile uint32_t readyEdges = 0;   // incremented by the GPIO interrupt
+	  uint32_t readyMark = 0;             // readyEdges at the last tune or search write
+
+	  // Asynchronous I2C transport, optional
+	  I2CAsync *asyncBus = nullptr;
+	  I2CAsyncTransfer asyncTransfer;
+	  uint8_t asyncTxBuffer[5];
+	  uint8_t asyncRxBuffer[5];
+
+	  // Asynchronous seek state
+	  TEA5767_SeekState_e seekState = TEA5767_SEEK_IDLE;
+	  bool seekMuting = false;
+	  uint8_t seekBandLimit = 0;
+	  bool seekVerify = false;        // verified seek mode
+	  uint8_t seekVerifyLevel = TEA5767_VERIFY_MIN_LEVEL;
+	  uint8_t seekStops = 0;          // false stops passed in this seek
+	  uint32_t seekFalseStops = 0;    // statistics
+	  absolute_time_t seekDeadline;
+	  absolute_time_t seekTimeout;
+	  TEA5767_SeekCallback_t seekCallback = nullptr;
+	  void *seekUserData = nullptr;
 		
-	  void setFrequency(float);
-	  void transmitFrequency(float);
+	  void setFrequency(uint32_t);
+	  void transmitFrequency(uint32_t);
 	  void transmitData();
+	  TEA5767_Settle_e settleNeeded();
+	  void settle(TEA5767_Settle_e policy);
+	  bool verifyStop();
+	  bool acceptStop();
+	  uint8_t segmentStopBits(uint32_t kHz);
+	  uint32_t lowerStopSegment(uint32_t stopKHz);
+	  void setBandBit(uint32_t kHz);
+	  uint8_t softSeekLevel(uint32_t kHz);
+	  int16_t writeRegisters();
+	  int16_t readRegisters();
+	  void recordTransmission(const uint8_t *data, int16_t returnValue);
+	  void decodeStatus(int16_t returnValue);
+	  void startWrite();
+	  void startRead();
+	  bool asyncPending();
+	  void asyncIdle();
 	  void initializeTransmissionData();
 	  void readStatus();
-	  float getFrequencyInMHz(unsigned int);
-	  void calculateOptimalHiLoInjection(float);
+	  uint32_t getFrequencyInKHz(uint16_t);
+	  void calculateOptimalHiLoInjection(uint32_t);
+	  bool lookupInjection(uint32_t);
+	  void storeInjection(uint32_t);
+	  void checkInjectionLevel(uint8_t);
 	  void setHighSideLOInjection();
 	  void setLowSideLOInjection();
 	  void setSoundOn();
@@ -95,16 +390,34 @@ class TEA5767N {
 		
 	public:
 
-	  TEA5767N();
+	  TEA5767N_T();
 	  void begin(uint8_t i2cAddress, i2c_inst_t* i2c_type, uint8_t SDApin, uint8_t SCLKpin, uint16_t CLKspeed);
-	  void deinitI2C(i2c_inst_t* i2c_type);
+	  void deinitI2C();
+	  Bus& getBus();
 	  void setDebug(bool OnOff);
+	  void setAsyncBus(I2CAsync *bus);
+	  bool setReadyPin(int8_t gpio, bool activeHigh = true);
+	  uint32_t getReadyEdges();
 	  bool GetIsConnected(void);
 	  void SetIsConnected(bool);
 	  int16_t CheckConnection(void);
 
-	  void selectFrequency(float);
-	  void selectFrequencyMuting(float);
+	  static uint16_t getPLLWord(uint32_t kHz, bool hiSide);
+
+	  void setBandPlan(TEA5767_BandPlan_e plan);
+	  const TEA5767_BandPlan_t& getBandPlan();
+	  TEA5767_BandPlan_e getBandPlanIndex();
+	  uint32_t tuneChannel(bool up);
+
+	  void setInjectionCache(uint32_t maxAgeMs, uint8_t levelDrop);
+	  void clearInjectionCache();
+	  uint32_t getInjectionProbes();
+	  uint32_t getInjectionHits();
+
+	  void selectFrequency(uint32_t);
+	  void selectFrequencyMuting(uint32_t);
+	  void tunePLL(uint32_t kHz, uint16_t pllWord, bool hiSide);
+	  bool isHighSideInjection();
 
 	  void mute();
 	  void turnTheSoundBackOn();
@@ -112,7 +425,7 @@ class TEA5767N {
 	  void turnTheLeftSoundBackOn();
 	  void muteRight();
 	  void turnTheRightSoundBackOn();
-	  float readFrequencyInMHz();
+	  uint32_t readFrequencyInKHz();
 
 	  void setSearchUp();
 	  void setSearchDown();
@@ -127,18 +440,55 @@ class TEA5767N {
 	  
 	  void setStandByOn();
 	  void setStandByOff();
+	  bool standby();
+	  bool resume();
+	  uint32_t getWakeLatencyUs();
 	  void setHighCutControlOn();
 	  void setHighCutControlOff();
 	  void setStereoNoiseCancellingOn();
 	  void setStereoNoiseCancellingOff();
+
+	  void beginTransaction();
+	  bool endTransaction();
+	  void invalidateTransmission();
+
+	  const RadioStatus& getStatus(bool forceRead = false);
+	  void setStatusMaxAge(uint32_t maxAgeMs);
+	  bool requestStatus();
+	  bool statusPending();
+	  bool isStatusValid();
+
+	  void setSettle(uint16_t shortMs, uint16_t pollMs, uint16_t timeoutMs);
+	  const TEA5767_SettleStats_t& getSettleStats();
+	  void resetSettleStats();
 	  
 	  uint8_t searchNext();
 	  uint8_t searchNextMuting();
-	  uint8_t startsSearchFrom(float frequency);
+	  uint8_t softSearchNext();
+	  uint8_t startsSearchFrom(uint32_t frequency);
 	  uint8_t startsSearchFromBeginning();
 	  uint8_t startsSearchFromEnd();
 	  uint8_t startsSearchMutingFromBeginning();
 	  uint8_t startsSearchMutingFromEnd();
+
+	  bool seekStart(bool muting = true, TEA5767_SeekCallback_t callback = nullptr, void *userData = nullptr);
+	  bool seekStartFrom(uint32_t frequency, bool muting = true, TEA5767_SeekCallback_t callback = nullptr, void *userData = nullptr);
+	  bool seekPoll();
+	  bool seekIsBusy();
+	  void setSeekVerify(bool verify, uint8_t minLevel = TEA5767_VERIFY_MIN_LEVEL);
+	  void setSeekWrap(bool wrap);
+	  bool getSeekWrap();
+	  uint32_t getSeekFalseStops();
+	  void setNoiseProfile(const TEA5767_NoiseProfile_t *profile, uint8_t margin = TEA5767_NOISE_MARGIN);
+	  void calibrateNoiseFloor(TEA5767_NoiseProfile_t &profile);
+	  void setSkipList(TEA5767_SkipList_t *list);
+	  bool setChannelSkip(uint32_t kHz, bool skip);
+	  bool isChannelSkipped(uint32_t kHz);
+	  uint32_t getSeekSkippedStops();
+	  uint8_t getNoiseThreshold(uint32_t kHz);
+	  TEA5767_SeekState_e seekGetState();
+	  uint8_t seekComplete();
+	  uint32_t getTunedFrequencyInKHz();
 	  uint8_t getSignalLevel();
 	  uint8_t isStereo();
 	  uint8_t isSearchUp();
@@ -148,4 +498,9 @@ class TEA5767N {
 	  
 };
 
+typedef TEA5767N_T<I2CHardwareBus> TEA5767N;       // hardware I2C, the default
+typedef TEA5767N_T<I2CAsyncBus> TEA5767N_Async;    // hardware I2C through a transfer queue
+typedef TEA5767N_T<I2CBitBangBus> TEA5767N_BitBang;// software I2C on any two GPIO
+typedef TEA5767N_T<I2CMockBus> TEA5767N_Mock;      // no hardware
+
 #endif
\ No newline at end of file
@@ -0,0 +1,81 @@
+/*
+ * Project Name: Library for the TEA5767HN FM radio Stereo Module
+ * File: tea5767_af.hpp
+ * Description: library header file, alternate frequency following, hops to
+ * a stronger frequency of the same programme when the tuned one fades
+ * Toolchain :: Rpi PICO ,rp2040, SDK C++
+ * Description: See URL for full details.
+ * URL: https://github.com/gavinlyonsrepo/TEA5767_PICO
+ */
+
+#ifndef TEA5767_AF_h
+#define TEA5767_AF_h
+
+#include "tea5767/tea5767.hpp"
+#include "tea5767/tea5767_monitor.hpp"
+
+#define TEA5767_AF_MAX_FREQS        4       // frequencies of one network, a preset and its alternates
+#define TEA5767_AF_LOW_LEVEL        6       // average level under which the alternates are checked
+#define TEA5767_AF_HYSTERESIS       2       // levels an alternate must beat the tuned frequency by
+#define TEA5767_AF_MIN_SAMPLES      2       // monitor samples before the level is trusted
+#define TEA5767_AF_RETRY_MS         10000   // mS between checks that found nothing better
+#define TEA5767_AF_NO_SIDE          0xFF    // injection side not learned yet
+
+// Frequencies carrying the same programme, e.g. a preset and its alternates
+struct TEA5767_AFNetwork_t
+{
+	uint32_t kHz[TEA5767_AF_MAX_FREQS];  // 0 = unused
+};
+
+// Station presets, each with its alternates, kept in flash
+#define TEA5767_PRESET_COUNT        5       // presets in the station menu
+
+struct TEA5767_PresetTable_t
+{
+	TEA5767_AFNetwork_t preset[TEA5767_PRESET_COUNT];  // kHz[0] is the preset
+	uint8_t count;                                      // presets in use
+};
+
+// Alternate frequency statistics
+struct TEA5767_AFStats_t
+{
+	uint32_t checks;       // times the alternates were measured
+	uint32_t switches;     // times a better alternate was kept
+	uint32_t lastGapUs;    // muted time of the last check, mute to audio
+	uint32_t maxGapUs;     // longest muted time
+	uint32_t lastSwitchUs; // muted time of the last check that switched
+};
+
+// Alternate frequency follower, templated on the bus backend of the radio
+template <class Bus>
+class TEA5767AltFreq_T {
+	public:
+	  TEA5767AltFreq_T(TEA5767N_T<Bus> &radio, TEA5767Monitor_T<Bus> &monitor);
+
+	  void setNetwork(const TEA5767_AFNetwork_t *network);
+	  void setThreshold(uint8_t lowLevel, uint8_t hysteresis, uint16_t retryMs = TEA5767_AF_RETRY_MS);
+	  bool poll();
+	  bool check();
+	  const TEA5767_AFStats_t& getStats();
+
+	private:
+	  int8_t findTuned();
+	  void learn(uint8_t index);
+	  void tune(uint8_t index);
+
+	  TEA5767N_T<Bus> &_radio;
+	  TEA5767Monitor_T<Bus> &_monitor;
+	  const TEA5767_AFNetwork_t *_network = nullptr;
+	  uint16_t _pllWord[TEA5767_AF_MAX_FREQS] = {};  // cached tuning of each frequency
+	  uint8_t _hiSide[TEA5767_AF_MAX_FREQS] = {};    // 1 high, 0 low, TEA5767_AF_NO_SIDE
+	  uint8_t _lowLevel = TEA5767_AF_LOW_LEVEL;
+	  uint8_t _hysteresis = TEA5767_AF_HYSTERESIS;
+	  uint16_t _retryMs = TEA5767_AF_RETRY_MS;
+	  uint32_t _sequence = 0;          // monitor sequence last looked at
+	  absolute_time_t _nextCheck;
+	  TEA5767_AFStats_t _stats = {0, 0, 0, 0, 0};
+};
+
+typedef TEA5767AltFreq_T<I2CHardwareBus> TEA5767AltFreq;
+
+#endif
@@ -0,0 +1,84 @@
+/*
+ * Project Name: Library for the TEA5767HN FM radio Stereo Module
+ * File: tea5767_monitor.hpp
+ * Description: library header file, background signal monitor with
+ * ring buffered level, stereo and IF history
+ * Toolchain :: Rpi PICO ,rp2040, SDK C++
+ * Description: See URL for full details.
+ * URL: https://github.com/gavinlyonsrepo/TEA5767_PICO
+ */
+
+#ifndef TEA5767_MONITOR_h
+#define TEA5767_MONITOR_h
+
+#include <atomic>
+#include "tea5767/tea5767.hpp"
+
+#define TEA5767_MONITOR_HISTORY     32     // samples kept in the ring buffer
+#define TEA5767_MONITOR_FAST_MS     500    // mS sample interval while the signal changes
+#define TEA5767_MONITOR_SLOW_MS     8000   // mS longest sample interval once stable
+#define TEA5767_MONITOR_CHANGE      2      // level step from the average that counts as changing
+#define TEA5767_MONITOR_EMA_SHIFT   2      // average weight of a new sample, 1/4
+
+// One signal sample
+struct TEA5767SignalSample
+{
+	uint32_t timeStamp;   // mS since boot
+	uint8_t level;        // ADC signal level 0-15
+	uint8_t ifCounter;    // IF counter 0-127
+	bool stereo;          // stereo reception
+};
+
+// Signal statistics over the history
+struct TEA5767SignalStats
+{
+	TEA5767SignalSample latest;  // newest sample
+	uint8_t minLevel;            // lowest level in the history
+	uint8_t maxLevel;            // highest level in the history
+	uint16_t emaLevel;           // moving average level, fixed point * 256
+	uint8_t count;               // samples in the history
+	uint8_t stereoCount;         // samples in the history with stereo
+	uint16_t intervalMs;         // current sample interval
+	uint32_t samples;            // samples taken since the station was tuned
+};
+
+// Signal monitor, templated on the bus backend of the radio
+template <class Bus>
+class TEA5767Monitor_T {
+	public:
+	  TEA5767Monitor_T(TEA5767N_T<Bus> &radio);
+
+	  void setRate(uint16_t fastMs, uint16_t slowMs);
+	  bool poll();
+	  void clear();
+
+	  // Lock free reads, no I2C traffic, not from an interrupt that can preempt poll()
+	  void getStats(TEA5767SignalStats &stats) const;
+	  bool getSample(uint8_t age, TEA5767SignalSample &sample) const;
+	  uint8_t getLevel() const;
+	  uint8_t getAverageLevel() const;
+	  bool isStereo() const;
+	  uint32_t getSequence() const;
+
+	private:
+	  void store(const RadioStatus &status);
+	  void beginWrite();
+	  void endWrite();
+
+	  TEA5767N_T<Bus> &_radio;
+	  uint16_t _fastMs = TEA5767_MONITOR_FAST_MS;
+	  uint16_t _slowMs = TEA5767_MONITOR_SLOW_MS;
+	  uint32_t _lastRequest = 0;
+	  bool _pending = false;          // status read on the bus
+	  int32_t _pllWord = -1;          // station the history belongs to
+
+	  // written by poll() only, guarded by _sequence for readers
+	  std::atomic<uint32_t> _sequence{0};   // odd while an update is in progress
+	  TEA5767SignalStats _stats = {};
+	  TEA5767SignalSample _history[TEA5767_MONITOR_HISTORY] = {};
+	  uint8_t _head = 0;              // next slot to write
+};
+
+typedef TEA5767Monitor_T<I2CHardwareBus> TEA5767Monitor;
+
+#endif
@@ -0,0 +1,69 @@
+/*
+ * Project Name: Library for the TEA5767HN FM radio Stereo Module
+ * File: tea5767_scan.hpp
+ * Description: library header file, full band scan building a station table
+ * Toolchain :: Rpi PICO ,rp2040, SDK C++
+ * Description: See URL for full details.
+ * URL: https://github.com/gavinlyonsrepo/TEA5767_PICO
+ */
+
+#ifndef TEA5767_SCAN_h
+#define TEA5767_SCAN_h
+
+#include "tea5767/tea5767.hpp"
+
+#define TEA5767_SCAN_MAX_STATIONS     32      // capacity of the station table
+#define TEA5767_SCAN_MERGE_CHANNELS   2       // stops within 2 * 50 kHz are one transmitter
+#define TEA5767_SCAN_BAND_EDGE        0       // kHz, start or end at the band plan edge
+#define TEA5767_RANK_SAMPLES          4       // level reads averaged per station when ranking
+#define TEA5767_RANK_INTERVAL_MS      10      // mS between those reads
+#define TEA5767_RANK_STEREO_BONUS     2       // levels a stereo station ranks above a mono one
+
+// One station found by the band scan, 4 bytes
+struct TEA5767Station
+{
+	uint16_t channel : 10;   // PLL table channel index, see TEA5767_ChannelToKHz
+	uint16_t level : 4;      // ADC signal level 0-15
+	uint16_t stereo : 1;     // stereo reception
+	uint8_t ifCounter;       // IF counter 0-127
+};
+
+// Band scan, templated on the bus backend of the radio
+template <class Bus>
+class TEA5767Scan_T {
+	public:
+	  TEA5767Scan_T(TEA5767N_T<Bus> &radio);
+
+	  bool start(uint32_t startKHz = TEA5767_SCAN_BAND_EDGE, uint32_t endKHz = TEA5767_SCAN_BAND_EDGE);
+	  uint8_t poll();
+	  void abort();
+	  bool isBusy();
+	  uint8_t getProgress();
+
+	  uint8_t getCount();
+	  const TEA5767Station& getStation(uint8_t index);
+	  uint32_t getStationKHz(uint8_t index);
+	  int16_t getStrongest();
+	  uint8_t rankStations(uint32_t *kHz, uint8_t maxCount, uint8_t samples = TEA5767_RANK_SAMPLES);
+	  void clear();
+
+	private:
+	  void addStation(uint32_t frequency, const RadioStatus &status);
+	  void removeStation(uint8_t index);
+
+	  TEA5767N_T<Bus> &_radio;
+	  bool _busy = false;
+	  uint32_t _startKHz = 0;
+	  uint32_t _endKHz = 0;
+	  uint32_t _lastKHz = 0;
+	  uint32_t _restoreKHz = 0;
+	  bool _wasMuted = false;
+	  bool _wasWrap = false;
+	  uint8_t _progress = 0;
+	  uint8_t _count = 0;
+	  TEA5767Station _stations[TEA5767_SCAN_MAX_STATIONS];
+};
+
+typedef TEA5767Scan_T<I2CHardwareBus> TEA5767Scan;
+
+#endif
@@ -12,9 +12,10 @@
 #include "pico/stdlib.h"
 #include "hardware/spi.h"
 #include "hardware/adc.h"
-#include <string>  // used by vector 
+#include <string>  // used by vector
 #include <vector> // used in menu display
 #include <time.h> // for settings function (time hold of the button)
+#include <string.h> // strcmp for the serial console commands
 
 
 // Custom libraries, all here https://github.com/gavinlyonsrepo/RPI_PICO_projects_list
@@ -22,17 +23,27 @@
 #include "ahtxx/ahtxx.hpp"   // Temperature Sensor
 #include "pushbutton/push_button.hpp" // Push button
 #include "tea5767/tea5767.hpp" // FM  radio module
+#include "tea5767/tea5767_scan.hpp" // FM  radio band scan
+#include "tea5767/tea5767_monitor.hpp" // FM  radio signal monitor
+#include "tea5767/tea5767_af.hpp" // FM  radio alternate frequency following
+#include "i2casync/i2c_async.hpp" // Interrupt driven I2C transfers
+#include "flashstore/flash_store.hpp" // Settings kept in flash
 #include "bitmapdata/bitmap_data.hpp" // Bitmap Data
 
 // === Setup ===
 
 // Timing display intervals
 const uint16_t intervalAHT10 = 9000;  // mS , AHT10, Recommended polling frequency: 8s-30s
-const uint16_t intervalRadioSignalLevel = 10000; // mS
+const uint16_t intervalRadioSignalLevel = 10000; // mS, slowest signal monitor rate once stable
+const uint16_t intervalRadioSignalFast = 500; // mS, signal monitor rate while level changing
 const uint16_t intervalVolDisplay = 5000; // mS
+const uint32_t intervalMuteStandby = 60000; // mS, muted this long the radio goes to standby
 
 // Misc
 #define I2C_CONNECTION_ATTEMPTS 3 // No of attempts to establish I2C connect at start
+#define SETTINGS_MENU_ITEMS 10 // entries in settings menu
+#define CONSOLE_LINE_LENGTH 24 // serial console command buffer
+#define MENU_ROWS_VISIBLE 6 // menu rows that fit on the screen, menu scrolls past this
 bool bDebugPrint = true; // If true debug information printed(in this main.cpp only)
 const uint StatusLEDPin = 25; // PICO on_board Status LED
 
@@ -55,32 +66,60 @@ DisplayMode_e DisplayMode = DisplayMode_Default;
 ERMCH1115  myOLED(2, 3, 4, 18, 19); 
 
 LIB_AHTXX myAHT10(AHT10_ADDRESS_0X38, AHT10_SENSOR); // AHT10
+I2CAsync sensorBus(i2c0); // asynchronous transfers for the AHT10
 
 // Radio
 typedef enum 
 {
 	RadioScan_Search = 2, // tunes automatically to signal, default
-	RadioFine_Tune = 3 // manually fine tunes in increments +/- 50kHz
+	RadioFine_Tune = 3 // manually fine tunes one channel of the band plan up or down
 }RadioScanMode_e; // sets the scan mode on search button press
 
 TEA5767N radio;
+I2CAsync radioBus(i2c1); // asynchronous transfers for the radio seek
+TEA5767Scan radioScan(radio);
+TEA5767Monitor radioMonitor(radio);
+TEA5767AltFreq radioAF(radio, radioMonitor);
+// Station menu presets, first entry shown in the menu, then alternate frequencies
+// of the same programme from other transmitter sites, 0 = unused. Edit for your area.
+// Used until Auto Store in the settings menu saves a table to flash.
+const TEA5767_PresetTable_t defaultPresets = {
+  {{{91000, 0, 0, 0}}, {{92230, 0, 0, 0}}, {{96340, 0, 0, 0}}, {{102640, 0, 0, 0}}, {{106150, 0, 0, 0}}}, 5
+};
+TEA5767_PresetTable_t presetTable = defaultPresets;
+FlashStore presetStore(FLASH_STORE_SECTOR_PRESETS, 0x50524531); // "PRE1"
 RadioScanMode_e RadioScanMode = RadioScan_Search;
+TEA5767_NoiseProfile_t noiseProfile = {}; // noise floor per band segment, set from settings menu
+FlashStore noiseStore(FLASH_STORE_SECTOR_NOISE, 0x4E4F4931); // "NOI1"
+TEA5767_SkipList_t skipList = {}; // channels the seeks pass over, set from settings menu or console
+FlashStore skipStore(FLASH_STORE_SECTOR_SKIP, 0x534B5031); // "SKP1"
 
 // === Function Prototypes ===
 void Setup(void);
 
 void SplashScreen(void); //Splash screen shown once at start-up
 
-void SelectStation(float &); // Select station screen shown at startup once
-float DisplaySelectMenu(int8_t);
+void SelectStation(uint32_t &); // Select station screen shown at startup once
+uint32_t DisplaySelectMenu(int8_t);
 
 void Settings(void); // Settings menu displayed if mute button held done > 3 seconds.
 void DisplaySettingsMenu(int8_t);
+void BandScan(void); // Full band scan run from settings menu
+bool RunBandScan(void);
+void AutoStore(void); // Band scan ranked into the station presets, run from settings menu
+void DisplayScanProgress(uint8_t);
+void DisplayScanResults(void);
+void NoiseCalibrate(void); // Noise floor calibration run from settings menu
+void SelectBandPlan(void); // Band plan cycled from settings menu
+void SkipStation(void); // Skip list entry of current station toggled from settings menu
+void CheckSerialConsole(void); // skip list commands over the serial port
+bool SetSkip(uint32_t, bool);
 
 // Check, read and display radio module
-void RadioIsConnect(float &);
-bool ReadRadioSignalLevel(uint8_t);
-void DisplayRadioInfo(uint8_t , float );
+void RadioIsConnect(uint32_t &);
+bool ReadRadioSignalLevel(uint8_t &);
+void DisplayRadioInfo(uint8_t , uint32_t );
+void PrintFrequency(uint32_t);
 // read and display volume info
 bool ReadVolLevel(uint16_t &);
 void DisplayVolInfo(uint16_t );
@@ -94,15 +133,18 @@ uint16_t map(uint32_t x, uint16_t in_min, uint16_t in_max, uint16_t out_min, uin
 clock_t clock(void); // used for timing button press to see if held down.
 
 bool CheckMuteButton(void); 
-bool CheckSearchUp(uint8_t &, float &);
-bool CheckSearchDown(uint8_t &, float &);
+void CheckIdleStandby(void);
+bool CheckSearchUp(uint8_t &, uint32_t &);
+bool CheckSearchDown(uint8_t &, uint32_t &);
+bool CheckSeekComplete(uint8_t &, uint32_t &);
+bool CheckAltFreq(uint8_t &, uint32_t &);
 
 // === Main ====
 int main()
 {
   float AHT10_Data[2];
   uint8_t signalLevel = 10;
-  float freqRadio = 98.4;  // Classic hits FM 98.4
+  uint32_t freqRadio = 98400;  // kHz, Classic hits FM 98.4
   uint16_t VolumeLevel = 125;
 
   Setup(); 
@@ -129,6 +171,10 @@ int main()
     if (CheckMuteButton()) DisplayVolInfo(VolumeLevel);
     if (CheckSearchUp(signalLevel, freqRadio)) DisplayRadioInfo(signalLevel , freqRadio);
     if (CheckSearchDown(signalLevel, freqRadio)) DisplayRadioInfo(signalLevel , freqRadio);
+    if (CheckSeekComplete(signalLevel, freqRadio)) DisplayRadioInfo(signalLevel , freqRadio);
+    if (CheckAltFreq(signalLevel, freqRadio)) DisplayRadioInfo(signalLevel , freqRadio);
+    CheckIdleStandby();
+    CheckSerialConsole();
   } // loop here forever, main loop
 } 
 
@@ -160,11 +206,14 @@ void Setup(void)
   // aht10 Sensor setup 
   // (port, data pin, clock pin, clock speed(KHZ));             
   myAHT10.AHT10_InitI2C(i2c0, 16, 17, 100);
+  sensorBus.begin();
+  myAHT10.AHT10_SetAsyncBus(&sensorBus);
   
   // Screen Setup :
   // initialize the OLED , contrast , Spi interface , spi Baud rate in Khz
   // Contrast 00 to FF , 0x80 is default. 
   myOLED.OLEDbegin(0x80, spi0, 8000); 
+  myOLED.OLEDbeginAsync(); // main screen updates by DMA, blocking if no channel free
   myOLED.setTextColor(FOREGROUND);
   myOLED.setFontNum(OLEDFontType_Default);
   myOLED.OLEDFillScreen(0x00, 0);
@@ -175,6 +224,17 @@ void Setup(void)
 
   // radio Init 
   radio.begin(TEA5767_I2C_ADDRESS, i2c1, 14, 15, 100);
+  radioBus.begin();
+  radio.setAsyncBus(&radioBus);
+  radio.setSeekVerify(true); // low stop level finds weak stations, IF check rejects false stops
+  radio.setSeekWrap(true); // seeks carry on from the other end of the band
+  radioMonitor.setRate(intervalRadioSignalFast, intervalRadioSignalLevel);
+  if (noiseStore.load(&noiseProfile, sizeof(noiseProfile)))
+    radio.setNoiseProfile(&noiseProfile); // seek stop level per band segment
+  skipStore.load(&skipList, sizeof(skipList)); // all zero skips nothing on first run
+  if (!presetStore.load(&presetTable, sizeof(presetTable)) || presetTable.count > TEA5767_PRESET_COUNT)
+    presetTable = defaultPresets;
+  radio.setSkipList(&skipList);
 }
 
 
@@ -224,44 +284,59 @@ uint16_t map(uint32_t x, uint16_t in_min, uint16_t in_max, uint16_t out_min, uin
 // Param 1 Pointer to a Array of two floats
 // One to hold temperature, One to hold Humidity data.
 // Returns: bool true = Data read , false =Data  not read or wrong display_mode
+// Note: measurement runs in the background, the loop keeps rendering while
+// the sensor converts.
 bool ReadAHT10(float* AHT10_data)
 {
     static uint32_t prevMillAHT10 = to_ms_since_boot(get_absolute_time());
+    static bool measuring = false;
     if (myAHT10.AHT10_GetIsConnected() == false) return false;
     if (DisplayMode == DisplayMode_Radio) return false;
 
-    if ((to_ms_since_boot(get_absolute_time()) - prevMillAHT10) >= intervalAHT10){ 
+    if (!measuring && (to_ms_since_boot(get_absolute_time()) - prevMillAHT10) >= intervalAHT10){ 
         prevMillAHT10 = to_ms_since_boot(get_absolute_time()); 
-        AHT10_data[0] = myAHT10.AHT10_readTemperature(true);
-        AHT10_data[1] = myAHT10.AHT10_readHumidity(true);
+        measuring = myAHT10.AHT10_StartMeasurement();
+        return false;
+    }
+    if (!measuring) return false;
+
+    switch (myAHT10.AHT10_PollMeasurement())
+    {
+      case AHT10_MEASURE_DONE:
+      case AHT10_MEASURE_ERROR:
+        measuring = false;
+        AHT10_data[0] = myAHT10.AHT10_readTemperature(AHT10_USE_READ_DATA);
+        AHT10_data[1] = myAHT10.AHT10_readHumidity(AHT10_USE_READ_DATA);
         if (bDebugPrint) printf("AHT10 Read %f \r\n", AHT10_data[0]);
         return true;
+      default:
+        return false;
     }
-  
-  return false;
 }
 
-//  Function used to read radio signal Level on define "intervalRadioSignalLevel"
-//  Param1 :: uint8_t :: Signal Level
-//  Returns: bool true = Data read, false = Data not read, or wrong display_mode
-bool ReadRadioSignalLevel(uint8_t SigLevel)
+//  Function used to read radio signal Level from the background signal monitor,
+//  which samples faster while the level changes, slower up to "intervalRadioSignalLevel" when stable.
+//  Param1 :: uint8_t :: Signal Level, updated when the monitor has a new level
+//  Returns: bool true = level changed, false = no change, or wrong display_mode
+bool ReadRadioSignalLevel(uint8_t &SigLevel)
 {
-    static uint32_t prevMillSignalLevel = to_ms_since_boot(get_absolute_time());
+    TEA5767SignalStats stats;
+    if (radio.isStandBy()) return false;
+    if (!radioMonitor.poll()) return false;
     if (DisplayMode == DisplayMode_Sensor) return false;
 
-    if ((to_ms_since_boot(get_absolute_time()) - prevMillSignalLevel) >= intervalRadioSignalLevel){ 
-        prevMillSignalLevel = to_ms_since_boot(get_absolute_time()); 
-        SigLevel = radio.getSignalLevel();
-        if (bDebugPrint) printf("Signal Level Read %u\r\n", SigLevel);
-        return true;
-  }
-  return false;
+    radioMonitor.getStats(stats);
+    if (bDebugPrint) printf("Signal Level Read %u min %u max %u next %u mS\r\n",
+      stats.latest.level, stats.minLevel, stats.maxLevel, stats.intervalMs);
+    if (stats.latest.level == SigLevel) return false;
+    SigLevel = stats.latest.level;
+    return true;
 }
 
 // Function to Display Radio information
 // Param1 Signal Level
-// Param2 Freq of radio station
-void DisplayRadioInfo(uint8_t SigLevel, float freqRadio){
+// Param2 Freq of radio station in kHz
+void DisplayRadioInfo(uint8_t SigLevel, uint32_t freqRadio){
 
         // Clear the radio area buffer
         myOLED.fillRect(0, 0, 128, 32, BACKGROUND);
@@ -280,7 +355,7 @@ void DisplayRadioInfo(uint8_t SigLevel, float freqRadio){
         myOLED.setCursor(22,0);
         myOLED.setTextSize(2);
         myOLED.setFontNum(OLEDFontType_Homespun);
-        myOLED.print(freqRadio,2);
+        PrintFrequency(freqRadio);
         myOLED.setTextSize(1);
         myOLED.setFontNum(OLEDFontType_Tiny);
         myOLED.setCursor(110,8);
@@ -289,7 +364,16 @@ void DisplayRadioInfo(uint8_t SigLevel, float freqRadio){
         myOLED.setCursor(20,20);
         myOLED.print(SigLevel);
 
-        myOLED.OLEDupdate();
+        myOLED.OLEDupdateAsync();
+}
+
+// Function to print a frequency in MHz with two decimal places
+// Param1 freq in kHz, integer formatting so no floating point needed
+void PrintFrequency(uint32_t freqkHz)
+{
+  char freqText[10];
+  snprintf(freqText, sizeof(freqText), "%lu.%02lu", (unsigned long)(freqkHz / 1000), (unsigned long)((freqkHz % 1000) / 10));
+  myOLED.print(freqText);
 }
 
 // Function to display Volume information
@@ -319,7 +403,7 @@ void DisplayVolInfo(uint16_t ADCResult)
       } else { // Muted print mute icon 
           myOLED.drawBitmap(1, 30, pMuteImage, 16, 16, BACKGROUND, FOREGROUND);
       }
-      myOLED.OLEDupdate();
+      myOLED.OLEDupdateAsync();
 }
 
 // Function to display the AHT10 information
@@ -400,7 +484,7 @@ void DisplayAHT10Info(float * AHT10_Data)
     }
   }
   // write to buffer
-  myOLED.OLEDupdate();
+  myOLED.OLEDupdateAsync();
 }
 
 
@@ -427,24 +511,23 @@ bool ReadVolLevel(uint16_t &VolLevel)
 // Function to check for a button press on the SearchUpBtn
 // This button will search up the radio band on press
 //  Param1 :: uint8_t Signal Level passed by reference
-//  Param2 :: (float) freq of radio passed by reference
+//  Param2 :: (uint32_t) freq of radio in kHz passed by reference
 //  Returns: bool true = button pressed, false button not pressed
-bool CheckSearchUp(uint8_t &sigLevel, float &freqRadio)
+bool CheckSearchUp(uint8_t &sigLevel, uint32_t &freqRadio)
 {
-    if (SearchUpBtn.IsPressed())
+    if (SearchUpBtn.IsPressed() && !radio.seekIsBusy())
     {
         if (bDebugPrint) printf("Button up pressed , scan mode %d\r\n", RadioScanMode);
+        if (radio.isStandBy()) radio.resume(); // wake first, the tuning kept in standby is restored
         if (RadioScanMode == RadioScan_Search)
         {
           radio.setSearchUp();
-          radio.setSearchLowStopLevel(); // try radio.setSearchMidStopLevel() if too sensitive
-          radio.searchNextMuting();
-          busy_wait_ms(700); // give time to let radio module tune 
-          freqRadio = radio.readFrequencyInMHz();
+          radio.setSearchLowStopLevel(); // false stops are skipped by the verified seek
+          radio.seekStart(true); // completes in CheckSeekComplete
+          return false;
         }else if (RadioScanMode == RadioFine_Tune)
         {
-          freqRadio = freqRadio + 0.05;
-          radio.selectFrequency(freqRadio);
+          freqRadio = radio.tuneChannel(true); // next channel of the band plan, wraps at the edge
           busy_wait_ms(50);
         }
         sigLevel = radio.getSignalLevel();
@@ -456,25 +539,23 @@ bool CheckSearchUp(uint8_t &sigLevel, float &freqRadio)
 // Function to check for a button press on the SearchDownBtn
 // This button will search down the radio band on press
 //  Param1 :: uint8_t Signal Level passed by reference
-//  Param2 :: (float) freq of radio passed by reference
+//  Param2 :: (uint32_t) freq of radio in kHz passed by reference
 //  Returns: bool true = button pressed, false button not pressed
-bool CheckSearchDown(uint8_t &sigLevel, float &freqRadio)
+bool CheckSearchDown(uint8_t &sigLevel, uint32_t &freqRadio)
 {
-    if (SearchDownBtn.IsPressed())
+    if (SearchDownBtn.IsPressed() && !radio.seekIsBusy())
     {
         if (bDebugPrint) printf("Button down pressed, scan mode %d\r\n",RadioScanMode);
+        if (radio.isStandBy()) radio.resume(); // wake first, the tuning kept in standby is restored
         if (RadioScanMode == RadioScan_Search)
         {
           radio.setSearchDown();
-          radio.setSearchLowStopLevel(); // try radio.setSearchMidStopLevel() if too sensitive
-          radio.searchNextMuting();
-          busy_wait_ms(700); // give time to let radio module tune 
-          freqRadio = radio.readFrequencyInMHz();
-         
+          radio.setSearchLowStopLevel(); // false stops are skipped by the verified seek
+          radio.seekStart(true); // completes in CheckSeekComplete
+          return false;
         }else if (RadioScanMode == RadioFine_Tune)
         {
-          freqRadio = freqRadio - 0.05;
-          radio.selectFrequency(freqRadio);
+          freqRadio = radio.tuneChannel(false);
           busy_wait_ms(50);
         }
       sigLevel = radio.getSignalLevel();
@@ -483,16 +564,54 @@ bool CheckSearchDown(uint8_t &sigLevel, float &freqRadio)
   return false;
 }
 
+// Function to drive the asynchronous seek started by the search buttons
+// Called every pass of main loop so buttons and display stay live during a seek
+//  Param1 :: uint8_t Signal Level passed by reference
+//  Param2 :: (uint32_t) freq of radio in kHz passed by reference
+//  Returns: bool true = seek completed on this call, false otherwise
+bool CheckSeekComplete(uint8_t &sigLevel, uint32_t &freqRadio)
+{
+    if (radio.seekPoll())
+    {
+        freqRadio = radio.getTunedFrequencyInKHz();
+        sigLevel = radio.getSignalLevel();
+        // seeks wrap at the band edges, a band limit means no station in the whole band
+        if (bDebugPrint) printf("Seek complete %lu kHz, band limit %u\r\n", (unsigned long)freqRadio, radio.seekComplete());
+        return true;
+    }
+  return false;
+}
+
+// Function to hop to a stronger alternate frequency of the preset when the tuned one fades
+// Called every pass of main loop, acts on new signal monitor samples only
+//  Param1 :: uint8_t Signal Level passed by reference
+//  Param2 :: (uint32_t) freq of radio in kHz passed by reference
+//  Returns: bool true = moved to an alternate, false otherwise
+bool CheckAltFreq(uint8_t &sigLevel, uint32_t &freqRadio)
+{
+    if (!radioAF.poll()) return false;
+    freqRadio = radio.getTunedFrequencyInKHz();
+    sigLevel = radio.getSignalLevel();
+    if (bDebugPrint) printf("Alternate frequency %lu kHz, muted %lu uS\r\n",
+      (unsigned long)freqRadio, (unsigned long)radioAF.getStats().lastSwitchUs);
+    return true;
+}
+
 // Function check if mute button pressed.
 // Returns: bool true = Data was read, false Data was not read
 // NOTE: if held for down for more than 3 seconds enters "settings Mode".
 bool CheckMuteButton(void)
 {
-  if (MuteBtn.IsPressed())
+  if (MuteBtn.IsPressed() && !radio.seekIsBusy())
   {
     clock_t startTime = clock();  // start clock
 
     if (bDebugPrint) printf("Mute button pressed \r\n");
+    if (radio.isStandBy()) // wake, the tuning kept in standby is restored
+    {
+      radio.resume();
+      if (bDebugPrint) printf("Radio resumed in %lu uS\r\n", (unsigned long)radio.getWakeLatencyUs());
+    }
     if (radio.isMuted())
       radio.turnTheSoundBackOn();
     else
@@ -510,11 +629,26 @@ bool CheckMuteButton(void)
   return false;
 }
 
+// Function puts the radio in standby once muted for "intervalMuteStandby"
+// Note the tuning is kept, the mute button resumes with one register write.
+void CheckIdleStandby(void)
+{
+  static uint32_t mutedSince = 0;
+  uint32_t now = to_ms_since_boot(get_absolute_time());
+  if (!radio.isMuted() || radio.seekIsBusy())
+  {
+    mutedSince = now;
+    return;
+  }
+  if (radio.isStandBy() || (now - mutedSince) < intervalMuteStandby) return;
+  if (radio.standby() && bDebugPrint) printf("Radio standby \r\n");
+}
+
 // Function to check if Radio connected at Start
-// Param1 :: freq of radio passed by reference(float)
+// Param1 :: freq of radio in kHz passed by reference(uint32_t)
 // Number of connection attempts defined by I2C_CONNECTION_ATTEMPTS
 // Changes member "isConnected" in radio library.
-void RadioIsConnect(float &freqRadio)
+void RadioIsConnect(uint32_t &freqRadio)
 {
   uint8_t connectionAttempts = 0;
   int16_t returnValue;
@@ -532,7 +666,7 @@ void RadioIsConnect(float &freqRadio)
       busy_wait_ms(2000);
       if (connectionAttempts++ == I2C_CONNECTION_ATTEMPTS){
         radio.SetIsConnected(false);
-        freqRadio = 0.0;
+        freqRadio = 0;
         return;
       } 
     }
@@ -540,17 +674,17 @@ void RadioIsConnect(float &freqRadio)
 }
 
 // Function handles control of station selection screen
-// Param1 freq of radio,
+// Param1 freq of radio in kHz,
 // Note shown at start-ip after splash  user selects a station here at startup
 // or just selects default( by selecting start), In this screen mute button selects option.
 // search buttons scan up and down menu options
-void SelectStation(float &freqRadio)
+void SelectStation(uint32_t &freqRadio)
 {
   myOLED.setFontNum(OLEDFontType_Default);
   myOLED.setTextSize(1);
   myOLED.OLEDfadeEffect(); // turn on fade effect
-  int8_t menuChoice = 0; // hold menu row index 0-5
-  float stationSelected = 0.0; // user menu choice
+  int8_t menuChoice = 0; // hold menu row index 0 to preset count
+  uint32_t stationSelected = 0; // user menu choice, kHz
   DisplaySelectMenu(menuChoice); // display menu first pass
 
   while(1)
@@ -558,21 +692,24 @@ void SelectStation(float &freqRadio)
     if (MuteBtn.IsPressed()) // mute press, leave 
     {
       if (menuChoice != 0)
+      {
         freqRadio = stationSelected;  
+        radioAF.setNetwork(&presetTable.preset[menuChoice - 1]); // follow its alternates
+      }
       break;
     }
 
     if (SearchDownBtn.IsPressed()) // Scan down menu
     {
       menuChoice ++;
-      if  (menuChoice == 6) menuChoice = 0;
+      if  (menuChoice > presetTable.count) menuChoice = 0;
       stationSelected = DisplaySelectMenu(menuChoice);
     }
 
     if (SearchUpBtn.IsPressed()) // scan up menu
     {
       menuChoice --;
-      if  (menuChoice == -1) menuChoice = 5;
+      if  (menuChoice == -1) menuChoice = presetTable.count;
       stationSelected = DisplaySelectMenu(menuChoice);
     }
 
@@ -583,42 +720,41 @@ void SelectStation(float &freqRadio)
 }
 
 // Function displays/draws the menu shown at station selection screen
-// Param1: the position in the menu 0-5
-// returns: A vector elements data, float with the freq of selected station
-// returns 0.0 if user is on menu position zero i.e "start" label
-float DisplaySelectMenu(int8_t menuChoice)
+// Param1: the position in the menu 0 to preset count
+// returns: uint32_t with the freq of selected preset in kHz
+// returns 0 if user is on menu position zero i.e "start" label
+uint32_t DisplaySelectMenu(int8_t menuChoice)
 {
-   uint8_t rowNo = 1;
-   std::vector<float> stationList = {91.00, 92.23, 96.34, 102.64, 106.15};
    myOLED.OLEDclearBuffer();
    myOLED.drawBitmap(0, 0, pRadioMastImage, 16, 16, BACKGROUND, FOREGROUND);
    myOLED.drawRoundRect(20, menuChoice * 10, 60, 10,5, FOREGROUND);
    myOLED.setCursor(30, 1);
    myOLED.print("Start");
-   for (float i : stationList) {
-    myOLED.setCursor(30, (rowNo++ * 10)+1);
-    myOLED.print(i);
+   for (uint8_t i = 0; i < presetTable.count; i++) {
+    myOLED.setCursor(30, ((i + 1) * 10)+1);
+    PrintFrequency(presetTable.preset[i].kHz[0]);
   }
 
    myOLED.OLEDupdate();
    if (menuChoice != 0)
-      return stationList[menuChoice-1];
+      return presetTable.preset[menuChoice-1].kHz[0];
     else 
-      return 0.0;
+      return 0;
     
 }
 
 // Function displays/draws the menu shown at settings screen
-// Param1: the position in the menu 0 or 1
+// Param1: the position in the menu 0 to SETTINGS_MENU_ITEMS-1
+// Note the list scrolls once the position is past the last visible row
 void DisplaySettingsMenu(int8_t menuChoice)
 {
   myOLED.OLEDclearBuffer();
-  uint8_t rowNo = 0;
-  std::vector<std::string> SettingsList= {"Scan Search", "Scan Fine Tune", "Display Default", "Display Radio", "Display AHT10"};
-  myOLED.drawRoundRect(10, menuChoice * 10, 112, 10,5, FOREGROUND);
-  for (std::string i :SettingsList) {
-    myOLED.setCursor(18, (rowNo++ * 10)+1);
-    myOLED.print(i);
+  std::vector<std::string> SettingsList= {"Scan Search", "Scan Fine Tune", "Display Default", "Display Radio", "Display AHT10", "Band Scan", "Noise Calibrate", "Band Plan", "Skip Station", "Auto Store"};
+  uint8_t firstRow = (menuChoice >= MENU_ROWS_VISIBLE) ? menuChoice - MENU_ROWS_VISIBLE + 1 : 0;
+  myOLED.drawRoundRect(10, (menuChoice - firstRow) * 10, 112, 10,5, FOREGROUND);
+  for (uint8_t rowNo = 0; rowNo < MENU_ROWS_VISIBLE && (firstRow + rowNo) < SettingsList.size(); rowNo++) {
+    myOLED.setCursor(18, (rowNo * 10)+1);
+    myOLED.print(SettingsList[firstRow + rowNo]);
   }
   myOLED.OLEDupdate();
 }
@@ -652,6 +788,11 @@ void Settings(void)
         case 2: DisplayMode = DisplayMode_Default; break;
         case 3: DisplayMode = DisplayMode_Radio; break;
         case 4: DisplayMode = DisplayMode_Sensor; break;
+        case 5: BandScan(); break;
+        case 6: NoiseCalibrate(); break;
+        case 7: SelectBandPlan(); break;
+        case 8: SkipStation(); break;
+        case 9: AutoStore(); break;
       }
       radio.turnTheSoundBackOn();
       break;
@@ -660,14 +801,14 @@ void Settings(void)
     if (SearchDownBtn.IsPressed()) // Scan down menu
     {
       menuChoice ++;
-      if  (menuChoice == 5) menuChoice = 0;
+      if  (menuChoice == SETTINGS_MENU_ITEMS) menuChoice = 0;
         DisplaySettingsMenu(menuChoice);
     }
 
     if (SearchUpBtn.IsPressed()) // scan up menu
     {
       menuChoice --;
-      if  (menuChoice == -1) menuChoice = 4;
+      if  (menuChoice == -1) menuChoice = SETTINGS_MENU_ITEMS - 1;
         DisplaySettingsMenu(menuChoice);
     }
   }; //end of while
@@ -677,6 +818,235 @@ void Settings(void)
   myOLED.OLEDupdate();
 }
 
+// Function runs a full band scan, selected from settings menu
+// Note Shows a progress bar while scanning, a search button press aborts.
+// The station tuned before the scan is restored at the end.
+void BandScan(void)
+{
+  if (!RunBandScan()) return;
+  DisplayScanResults();
+  while (MuteBtn.IsPressed() == false) // wait for user to leave results
+    {busy_wait_ms(1);}
+}
+
+// Function drives a band scan to the end showing the progress bar
+// Returns: bool false if the scan could not start
+bool RunBandScan(void)
+{
+  uint8_t progress = 0;
+  uint8_t lastProgress = 0xFF;
+  radio.setSearchLowStopLevel();
+  if (!radioScan.start()) return false;
+  while (radioScan.isBusy())
+  {
+    progress = radioScan.poll();
+    if (SearchUpBtn.IsPressed() || SearchDownBtn.IsPressed()) 
+      radioScan.abort();
+    if (progress != lastProgress)
+    {
+      DisplayScanProgress(progress);
+      lastProgress = progress;
+    }
+  }
+  if (bDebugPrint) printf("Band scan found %u stations\r\n", radioScan.getCount());
+  return true;
+}
+
+// Function fills the station presets from a band scan, selected from settings menu
+// Note stations are ranked by averaged level, stereo and IF check, the best
+// TEA5767_PRESET_COUNT are saved to flash and shown in the station menu from now on.
+// Alternates of the old presets are dropped. An empty scan keeps the old presets.
+void AutoStore(void)
+{
+  uint32_t ranked[TEA5767_PRESET_COUNT];
+  if (!RunBandScan()) return;
+  uint8_t count = radioScan.rankStations(ranked, TEA5767_PRESET_COUNT);
+  bool saved = false;
+  if (count > 0)
+  {
+    radioAF.setNetwork(nullptr); // may point into the table
+    presetTable = {};
+    for (uint8_t i = 0; i < count; i++) presetTable.preset[i].kHz[0] = ranked[i];
+    presetTable.count = count;
+    saved = presetStore.save(&presetTable, sizeof(presetTable));
+  }
+  if (bDebugPrint) printf("Auto store %u presets, saved %u\r\n", count, saved);
+
+  myOLED.OLEDclearBuffer();
+  myOLED.setFontNum(OLEDFontType_Default);
+  myOLED.setCursor(10, 1);
+  myOLED.print(saved ? "Presets stored" : "Not stored");
+  for (uint8_t i = 0; i < count; i++)
+  {
+    myOLED.setCursor(10, ((i + 1) * 10) + 1);
+    PrintFrequency(ranked[i]);
+  }
+  myOLED.OLEDupdate();
+  while (MuteBtn.IsPressed() == false) // wait for user to leave results
+    {busy_wait_ms(1);}
+}
+
+// Function displays the band scan progress bar
+// Param1: progress 0-100
+void DisplayScanProgress(uint8_t progress)
+{
+  myOLED.OLEDclearBuffer();
+  myOLED.drawBitmap(0, 0, pRadioMastImage, 16, 16, BACKGROUND, FOREGROUND);
+  myOLED.setFontNum(OLEDFontType_Default);
+  myOLED.setCursor(24, 4);
+  myOLED.print("Band Scan");
+  myOLED.drawRoundRect(4, 28, 120, 10, 5, FOREGROUND);
+  myOLED.fillRoundRect(4, 28, map(progress, 0, 100, 10, 120), 10, 5, FOREGROUND);
+  myOLED.setCursor(24, 44);
+  myOLED.print("Found ");
+  myOLED.print(radioScan.getCount());
+  myOLED.OLEDupdate();
+}
+
+// Function displays the stations found by the band scan
+// Note up to six stations shown, frequency and signal level
+void DisplayScanResults(void)
+{
+  myOLED.OLEDclearBuffer();
+  myOLED.setFontNum(OLEDFontType_Default);
+  if (radioScan.getCount() == 0)
+  {
+    myOLED.setCursor(10, 28);
+    myOLED.print("No stations");
+  }
+  for (uint8_t i = 0; i < radioScan.getCount() && i < 6; i++)
+  {
+    myOLED.setCursor(10, (i * 10) + 1);
+    PrintFrequency(radioScan.getStationKHz(i));
+    myOLED.setCursor(70, (i * 10) + 1);
+    myOLED.print("L");
+    myOLED.print((int)radioScan.getStation(i).level);
+    if (radioScan.getStation(i).stereo) myOLED.print(" ST");
+  }
+  myOLED.OLEDupdate();
+}
+
+// Function runs the noise floor calibration, selected from settings menu
+// Note every channel of the band is tuned once, the profile is saved to flash
+// so it is used by the seeks from the next start-up too.
+void NoiseCalibrate(void)
+{
+  myOLED.OLEDclearBuffer();
+  myOLED.drawBitmap(0, 0, pRadioMastImage, 16, 16, BACKGROUND, FOREGROUND);
+  myOLED.setFontNum(OLEDFontType_Default);
+  myOLED.setCursor(24, 4);
+  myOLED.print("Noise Calibrate");
+  myOLED.setCursor(24, 28);
+  myOLED.print("Please wait");
+  myOLED.OLEDupdate();
+
+  radio.calibrateNoiseFloor(noiseProfile);
+  radio.setNoiseProfile(&noiseProfile);
+  bool saved = noiseStore.save(&noiseProfile, sizeof(noiseProfile));
+  if (bDebugPrint) printf("Noise floor calibrated, saved %u\r\n", saved);
+
+  myOLED.setCursor(24, 44);
+  myOLED.print(saved ? "Saved" : "Not saved");
+  myOLED.OLEDupdate();
+  busy_wait_ms(1000);
+}
+
+// Function selects the next band plan, selected from settings menu
+// Note EU 100 kHz, US odd 200 kHz and Japan 76-95 MHz in turn. The station
+// is kept, the next seek or fine tune moves on to the channels of the new plan.
+void SelectBandPlan(void)
+{
+  radio.setBandPlan((TEA5767_BandPlan_e)((radio.getBandPlanIndex() + 1) % TEA5767_BAND_PLAN_COUNT));
+  const TEA5767_BandPlan_t &plan = radio.getBandPlan();
+  if (bDebugPrint) printf("Band plan %s, %lu-%lu kHz\r\n", plan.name, (unsigned long)plan.lowKHz, (unsigned long)plan.highKHz);
+
+  myOLED.OLEDclearBuffer();
+  myOLED.drawBitmap(0, 0, pRadioMastImage, 16, 16, BACKGROUND, FOREGROUND);
+  myOLED.setFontNum(OLEDFontType_Default);
+  myOLED.setCursor(24, 4);
+  myOLED.print("Band Plan");
+  myOLED.setCursor(24, 28);
+  myOLED.print(plan.name);
+  myOLED.print(" ");
+  myOLED.print((int)plan.rasterKHz);
+  myOLED.print(" kHz");
+  myOLED.OLEDupdate();
+  busy_wait_ms(1000);
+}
+
+// Function adds the current station to the skip list, or removes it if already there
+// Note selected from settings menu, the list is saved to flash.
+// Seeks and band scan then pass over the station.
+void SkipStation(void)
+{
+  uint32_t freqRadio = radio.getTunedFrequencyInKHz();
+  bool skip = !radio.isChannelSkipped(freqRadio);
+  bool saved = SetSkip(freqRadio, skip);
+
+  myOLED.OLEDclearBuffer();
+  myOLED.drawBitmap(0, 0, pRadioMastImage, 16, 16, BACKGROUND, FOREGROUND);
+  myOLED.setFontNum(OLEDFontType_Default);
+  myOLED.setCursor(24, 4);
+  myOLED.print("Skip Station");
+  myOLED.setCursor(24, 28);
+  PrintFrequency(freqRadio);
+  myOLED.setCursor(24, 44);
+  myOLED.print(!saved ? "Not saved" : (skip ? "Skipped" : "Not skipped"));
+  myOLED.OLEDupdate();
+  busy_wait_ms(1000);
+}
+
+// Function sets a skip list entry and saves the list to flash
+// Param1 :: kHz of the channel
+// Param2 :: true skip it, false stop on it again
+// Returns :: bool true if set and saved
+bool SetSkip(uint32_t kHz, bool skip)
+{
+  if (!radio.setChannelSkip(kHz, skip)) return false;
+  bool saved = skipStore.save(&skipList, sizeof(skipList));
+  if (bDebugPrint) printf("Skip %lu kHz %u, saved %u\r\n", (unsigned long)kHz, skip, saved);
+  return saved;
+}
+
+// Function reads skip list commands from the serial port, never blocks
+// Note one command per line, frequency in kHz, none means the current station
+//   skip [kHz]   add a channel to the skip list
+//   unskip [kHz] remove a channel from the skip list
+//   skips        list the skipped channels
+void CheckSerialConsole(void)
+{
+  static char line[CONSOLE_LINE_LENGTH];
+  static uint8_t length = 0;
+  int c = getchar_timeout_us(0);
+  if (c == PICO_ERROR_TIMEOUT) return;
+  if (c != '\r' && c != '\n')
+  {
+    if (length < CONSOLE_LINE_LENGTH - 1) line[length++] = (char)c;
+    return;
+  }
+  line[length] = '\0';
+  if (length == 0) return;
+  length = 0;
+
+  unsigned long kHz = 0;
+  char command[8] = {0};
+  if (sscanf(line, "%7s %lu", command, &kHz) < 1) return;
+  if (kHz == 0) kHz = radio.getTunedFrequencyInKHz();
+  if (strcmp(command, "skip") == 0 || strcmp(command, "unskip") == 0)
+  {
+    bool saved = SetSkip(kHz, command[0] == 's');
+    printf("%s %lu kHz %s\r\n", command, kHz, saved ? "ok" : "failed");
+  } else if (strcmp(command, "skips") == 0)
+  {
+    for (uint16_t channel = 0; channel < TEA5767_CHANNEL_COUNT; channel++)
+    {
+      if ((skipList.bits[channel / 8] >> (channel & 7)) & 1)
+        printf("%lu\r\n", (unsigned long)TEA5767_ChannelToKHz(channel));
+    }
+  } else
+    printf("commands: skip [kHz], unskip [kHz], skips\r\n");
+}
+
 clock_t clock()
 {
     return (clock_t) time_us_64() / 10000;
@@ -13,32 +13,29 @@
 // Param 1 I2C address
 // Param 2 Enum with Sensor types
 
-LIB_AHTXX::LIB_AHTXX(uint8_t address, ASAIR_I2C_SENSOR_e sensorName) {
+template <class Bus>
+LIB_AHTXX_T<Bus>::LIB_AHTXX_T(uint8_t address, ASAIR_I2C_SENSOR_e sensorName) {
 	_address = address;
 	_sensorName = sensorName;
 }
 
 // Function Desc Initialise the I2C
-// Param 1 : IC2 interface ic20 i2c1 etc
+// Param 1 : IC2 interface ic20 i2c1 etc, stored in the bus backend
 // Param 2 : Data pin I2C
 // Param 3 : Clock pin I2C
 // Param 4 : I2C Clock speed in Khz 0-400Khz
 // NOTE :: call before begin method
 
-void LIB_AHTXX::AHT10_InitI2C(i2c_inst_t* i2c_type, uint8_t  SDApin, uint8_t  SCLKpin, uint16_t CLKspeed) {
-	i2c_inst_t *i2c = i2c_type;
-	//init I2C
-	i2c_init(i2c, CLKspeed * 1000);
-	gpio_set_function(SDApin, GPIO_FUNC_I2C);
-    gpio_set_function(SCLKpin, GPIO_FUNC_I2C);
-	gpio_pull_up(SDApin);
-    gpio_pull_up(SCLKpin);
+template <class Bus>
+void LIB_AHTXX_T<Bus>::AHT10_InitI2C(i2c_inst_t* i2c_type, uint8_t  SDApin, uint8_t  SCLKpin, uint16_t CLKspeed) {
+	bus.init(i2c_type, SDApin, SCLKpin, CLKspeed);
 }
 
  // Function desc: Initialize I2C & configure the sensor, call this function before
  // Returns bool true init success False failure
 
-bool LIB_AHTXX::AHT10_begin()
+template <class Bus>
+bool LIB_AHTXX_T<Bus>::AHT10_begin()
 {
 	busy_wait_ms(AHT10_POWER_ON_DELAY);    //wait for sensor to initialize
 	AHT10_setNormalMode();                //one measurement+sleep mode
@@ -53,14 +50,15 @@ bool LIB_AHTXX::AHT10_begin()
 //  Function Desc :: readRawData()  Read raw measurement data from sensor over I2C
 //  Returns AHT10_ERROR for failure, true for success with data in the buffer
 
-uint8_t LIB_AHTXX::AHT10_readRawData() {
+template <class Bus>
+uint8_t LIB_AHTXX_T<Bus>::AHT10_readRawData() {
 
 	uint8_t bufTX[3];
 	bufTX[0] = AHT10_START_MEASURMENT_CMD;
 	bufTX[1] = AHT10_DATA_MEASURMENT_CMD;
 	bufTX[2] = AHT10_DATA_NOP;
 	// 	Send measurement command
-	returnValue = i2c_write_timeout_us(i2c, _address, bufTX, 3 ,false, AHT10_MY_I2C_DELAY );
+	returnValue = bus.write(_address, bufTX, 3, AHT10_MY_I2C_DELAY);
 	if (returnValue < 1 )
 		return AHT10_ERROR; //error handler, collision on I2C bus
 
@@ -70,7 +68,7 @@ uint8_t LIB_AHTXX::AHT10_readRawData() {
 		busy_wait_ms(AHT10_MEASURMENT_DELAY); // measurement delay
 
 	// Read 6-bytes from sensor
-	returnValue = i2c_read_timeout_us(i2c, _address, _rawDataBuffer, 6 ,false, AHT10_MY_I2C_DELAY  );
+	returnValue = bus.read(_address, _rawDataBuffer, 6, AHT10_MY_I2C_DELAY);
 	if (returnValue < 1) {
 		_rawDataBuffer[0] = AHT10_ERROR;
 		return AHT10_ERROR;
@@ -87,7 +85,8 @@ uint8_t LIB_AHTXX::AHT10_readRawData() {
 // temperature resolution 0.01°C
 // temperature accuracy   ±0.3°C
 
-float LIB_AHTXX::AHT10_readTemperature(bool readI2C) {
+template <class Bus>
+float LIB_AHTXX_T<Bus>::AHT10_readTemperature(bool readI2C) {
 	if (readI2C == AHT10_FORCE_READ_DATA) {
 		if (AHT10_readRawData() == AHT10_ERROR)
 			return AHT10_ERROR; //force to read data to _rawDataBuffer & error handler
@@ -111,7 +110,8 @@ float LIB_AHTXX::AHT10_readTemperature(bool readI2C) {
 //- relative humidity resolution 0.024%
 // - relative humidity accuracy   ±2%
 
-float LIB_AHTXX::AHT10_readHumidity(bool readI2C) {
+template <class Bus>
+float LIB_AHTXX_T<Bus>::AHT10_readHumidity(bool readI2C) {
 	if (readI2C == AHT10_FORCE_READ_DATA) {
 		if (AHT10_readRawData() == AHT10_ERROR)
 			return AHT10_ERROR; //force to read data to _rawDataBuffer & error handler
@@ -139,12 +139,13 @@ float LIB_AHTXX::AHT10_readHumidity(bool readI2C) {
 // - takes ~20ms
 // - all registers restores to default
 
-bool LIB_AHTXX::AHT10_softReset(void) {
+template <class Bus>
+bool LIB_AHTXX_T<Bus>::AHT10_softReset(void) {
 	//MX_I2C1_Init;
 	uint8_t bufTX[1];
 	bufTX[0]= AHT10_SOFT_RESET_CMD;
 
-	returnValue = i2c_write_timeout_us(i2c, _address, bufTX, 1 ,false , AHT10_MY_I2C_DELAY );
+	returnValue = bus.write(_address, bufTX, 1, AHT10_MY_I2C_DELAY);
 	if (returnValue < 1)
 		return false;
 
@@ -157,14 +158,15 @@ bool LIB_AHTXX::AHT10_softReset(void) {
 // Function Desc setNormalMode() Set normal measurement mode
 // Returns True for success , false for failure
 
-bool LIB_AHTXX::AHT10_setNormalMode(void) {
+template <class Bus>
+bool LIB_AHTXX_T<Bus>::AHT10_setNormalMode(void) {
 	uint8_t bufTX[3];
 
 	bufTX[0] = AHT10_NORMAL_CMD;
 	bufTX[1] = AHT10_DATA_NOP;
 	bufTX[2] = AHT10_DATA_NOP;
 
-	returnValue = i2c_write_timeout_us(i2c, _address, bufTX, 3 ,false , AHT10_MY_I2C_DELAY );
+	returnValue = bus.write(_address, bufTX, 3, AHT10_MY_I2C_DELAY);
 	if (returnValue < 1)
 		return false; //safety check, make sure transmission complete
 
@@ -176,7 +178,8 @@ bool LIB_AHTXX::AHT10_setNormalMode(void) {
 
 // Function Desc  setCycleMode(),  Set cycle measurement, mode continuous measurement
 // Returns True for success , false for failure
-bool LIB_AHTXX::AHT10_setCycleMode(void) {
+template <class Bus>
+bool LIB_AHTXX_T<Bus>::AHT10_setCycleMode(void) {
 	uint8_t bufTX[3];
 
 	if (_sensorName != AHT20_SENSOR)
@@ -185,7 +188,7 @@ bool LIB_AHTXX::AHT10_setCycleMode(void) {
 		bufTX[0] = AHT20_INIT_CMD;
 	bufTX[1] = AHT10_INIT_CYCLE_MODE | AHT10_INIT_CAL_ENABLE;
 	bufTX[2] = AHT10_DATA_NOP;
-	returnValue = i2c_write_timeout_us(i2c, _address, bufTX, 3 ,false, AHT10_MY_I2C_DELAY  );
+	returnValue = bus.write(_address, bufTX, 3, AHT10_MY_I2C_DELAY);
 
 	if (returnValue < 1)
 		return false; //safety check, make sure transmission complete
@@ -198,9 +201,10 @@ bool LIB_AHTXX::AHT10_setCycleMode(void) {
 // Function Desc :  readStatusByte() , Read status byte from sensor over I2C
 // Returns Status byte success or AHT10_ERROR failure
 
-uint8_t LIB_AHTXX::AHT10_readStatusByte() {
+template <class Bus>
+uint8_t LIB_AHTXX_T<Bus>::AHT10_readStatusByte() {
 
-	returnValue = i2c_read_timeout_us(i2c, _address, _rawDataBuffer, 1 ,false, AHT10_MY_I2C_DELAY );
+	returnValue = bus.read(_address, _rawDataBuffer, 1, AHT10_MY_I2C_DELAY);
 
 	if (returnValue < 1) {
 		_rawDataBuffer[0] = AHT10_ERROR;
@@ -219,7 +223,8 @@ uint8_t LIB_AHTXX::AHT10_readStatusByte() {
 // - 0, factory calibration coeff disabled
 // - 1, factory calibration coeff loaded
 
-uint8_t LIB_AHTXX::AHT10_getCalibrationBit(bool readI2C) {
+template <class Bus>
+uint8_t LIB_AHTXX_T<Bus>::AHT10_getCalibrationBit(bool readI2C) {
 	uint8_t valueBit;
 	if (readI2C == AHT10_FORCE_READ_DATA)
 		_rawDataBuffer[0] = AHT10_readStatusByte(); //force to read status byte
@@ -237,7 +242,8 @@ uint8_t LIB_AHTXX::AHT10_getCalibrationBit(bool readI2C) {
 // Function Desc : enableFactoryCalCoeff() , Load factory calibration coefficients
 // returns true for success, false for failure
 
-bool LIB_AHTXX::AHT10_enableFactoryCalCoeff() {
+template <class Bus>
+bool LIB_AHTXX_T<Bus>::AHT10_enableFactoryCalCoeff() {
 
 	uint8_t bufTX[3];
 	if (_sensorName != AHT20_SENSOR)
@@ -248,7 +254,7 @@ bool LIB_AHTXX::AHT10_enableFactoryCalCoeff() {
 	bufTX[1] = AHT10_INIT_CAL_ENABLE;
 	bufTX[2] = AHT10_DATA_NOP;
 
-	returnValue = i2c_write_timeout_us(i2c, _address, bufTX, 3 ,false, AHT10_MY_I2C_DELAY  );
+	returnValue = bus.write(_address, bufTX, 3, AHT10_MY_I2C_DELAY);
 	
 	if (returnValue < 1)
 	{
@@ -272,7 +278,8 @@ bool LIB_AHTXX::AHT10_enableFactoryCalCoeff() {
 // - 0, sensor idle & sleeping
 // - 1, sensor busy & in measurement state
 
-uint8_t LIB_AHTXX::AHT10_getBusyBit(bool readI2C) {
+template <class Bus>
+uint8_t LIB_AHTXX_T<Bus>::AHT10_getBusyBit(bool readI2C) {
 	uint8_t valueBit;
 	if (readI2C == AHT10_FORCE_READ_DATA)
 		_rawDataBuffer[0] = AHT10_readStatusByte(); // Read status byte
@@ -288,18 +295,129 @@ uint8_t LIB_AHTXX::AHT10_getBusyBit(bool readI2C) {
 }
 
 
-void LIB_AHTXX::AHT10_DeInit(i2c_inst_t* i2c_type)
+template <class Bus>
+void LIB_AHTXX_T<Bus>::AHT10_DeInit()
 {
-	i2c_inst_t *i2c = i2c_type;
-	i2c_deinit(i2c); 	
+	bus.deinit();
 }
 
-void LIB_AHTXX::AHT10_SetIsConnected(bool connected)
+// Function Desc : AHT10_GetBus(), the bus backend, e.g. to set up a mock or queue before init
+template <class Bus>
+Bus& LIB_AHTXX_T<Bus>::AHT10_GetBus()
+{
+	return bus;
+}
+
+// Function Desc : AHT10_SetAsyncBus(), use an asynchronous I2C transport for measurements
+// Param1 : transport on the same I2C interface as AHT10_InitI2C, nullptr = blocking calls
+// NOTES: only AHT10_StartMeasurement / AHT10_PollMeasurement use the transport,
+// the other functions stay blocking and are for setup.
+
+template <class Bus>
+void LIB_AHTXX_T<Bus>::AHT10_SetAsyncBus(I2CAsync *asyncBus)
+{
+	if (_asyncBus != nullptr)
+		_asyncBus->flush();
+	_asyncBus = asyncBus;
+}
+
+// Function Desc : AHT10_StartMeasurement(), start a measurement without blocking
+// Returns false if a measurement is already running
+// NOTES: call AHT10_PollMeasurement() from the main loop until it returns
+// AHT10_MEASURE_DONE, then read the results with AHT10_USE_READ_DATA.
+
+template <class Bus>
+bool LIB_AHTXX_T<Bus>::AHT10_StartMeasurement(void)
+{
+	if (_measureState != AHT10_MEASURE_IDLE && _measureState != AHT10_MEASURE_DONE
+		&& _measureState != AHT10_MEASURE_ERROR)
+		return false;
+
+	_asyncTxBuffer[0] = AHT10_START_MEASURMENT_CMD;
+	_asyncTxBuffer[1] = AHT10_DATA_MEASURMENT_CMD;
+	_asyncTxBuffer[2] = AHT10_DATA_NOP;
+	if (_asyncBus != nullptr)
+	{
+		_asyncBus->submitWrite(_asyncTransfer, _address, _asyncTxBuffer, 3);
+	} else {
+		returnValue = bus.write(_address, _asyncTxBuffer, 3, AHT10_MY_I2C_DELAY);
+		_asyncTransfer.status = (returnValue < 1) ? I2C_ASYNC_ERROR : I2C_ASYNC_DONE;
+	}
+	_measureState = AHT10_MEASURE_TRIGGER;
+	return true;
+}
+
+// Function Desc : AHT10_PollMeasurement(), drive a measurement started by AHT10_StartMeasurement
+// Returns the measurement state, AHT10_MEASURE_DONE when data is in the buffer
+// NOTES: never waits out the measurement delay, each call does at most one
+// short I2C transfer when no asynchronous transport is attached.
+
+template <class Bus>
+AHT10_MeasureState_e LIB_AHTXX_T<Bus>::AHT10_PollMeasurement(void)
+{
+	if (_asyncBus != nullptr && _asyncTransfer.isPending())
+	{
+		_asyncBus->poll();
+		if (_asyncTransfer.isPending())
+			return _measureState;
+	}
+
+	switch (_measureState)
+	{
+		case AHT10_MEASURE_TRIGGER:
+			if (_asyncTransfer.status != I2C_ASYNC_DONE) {
+				_rawDataBuffer[0] = AHT10_ERROR;
+				_measureState = AHT10_MEASURE_ERROR;
+				break;
+			}
+			_measureDeadline = make_timeout_time_ms(AHT10_MEASURMENT_DELAY);
+			_measureState = AHT10_MEASURE_WAIT;
+		break;
+		case AHT10_MEASURE_WAIT:
+			if (!time_reached(_measureDeadline))
+				break;
+			if (_asyncBus != nullptr)
+			{
+				_asyncBus->submitRead(_asyncTransfer, _address, _rawDataBuffer, 6);
+			} else {
+				returnValue = bus.read(_address, _rawDataBuffer, 6, AHT10_MY_I2C_DELAY);
+				_asyncTransfer.status = (returnValue < 1) ? I2C_ASYNC_ERROR : I2C_ASYNC_DONE;
+			}
+			_measureState = AHT10_MEASURE_READ;
+		break;
+		case AHT10_MEASURE_READ:
+			if (_asyncTransfer.status != I2C_ASYNC_DONE || AHT10_getCalibrationBit(AHT10_USE_READ_DATA) != 0x01) {
+				_rawDataBuffer[0] = AHT10_ERROR;
+				_measureState = AHT10_MEASURE_ERROR;
+				break;
+			}
+			if (AHT10_getBusyBit(AHT10_USE_READ_DATA) != 0x00) {
+				// conversion not finished, read again after a short wait
+				_measureDeadline = make_timeout_time_ms(AHT10_MEASURMENT_DELAY / 4);
+				_measureState = AHT10_MEASURE_WAIT;
+				break;
+			}
+			_measureState = AHT10_MEASURE_DONE;
+		break;
+		default: break;
+	}
+	return _measureState;
+}
+
+template <class Bus>
+void LIB_AHTXX_T<Bus>::AHT10_SetIsConnected(bool connected)
 {
 	isConnected = connected;
 }
 
-bool LIB_AHTXX::AHT10_GetIsConnected(void)
+template <class Bus>
+bool LIB_AHTXX_T<Bus>::AHT10_GetIsConnected(void)
 {
 	return isConnected;
-}
\ No newline at end of file
+}
+
+// Bus backends available to applications
+template class LIB_AHTXX_T<I2CHardwareBus>;
+template class LIB_AHTXX_T<I2CAsyncBus>;
+template class LIB_AHTXX_T<I2CBitBangBus>;
+template class LIB_AHTXX_T<I2CMockBus>;
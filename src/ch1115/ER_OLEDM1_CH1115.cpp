@@ -6,10 +6,40 @@
 * URL: https://github.com/gavinlyonsrepo/ER_OLEDM1_CH1115_PICO
 */
 #include <stdio.h>
+#include <string.h>
 #include "pico/stdlib.h"
+#include "hardware/dma.h"
+#include "hardware/irq.h"
 #include "../include/ch1115/ER_OLEDM1_CH1115.hpp"
 #include "../include/ch1115/ER_OLEDM1_CH1115_graphics.hpp"
 
+// Power on register settings, sent as one command run by OLEDinit
+static constexpr uint8_t ERMCH1115_InitSequence[] = {
+	ERMCH1115_DISPLAY_OFF,
+	ERMCH1115_SET_COLADD_LSB, ERMCH1115_SET_COLADD_MSB, ERMCH1115_SET_PAGEADD,
+	ERMCH115_SET_DISPLAY_START_LINE,
+	ERMCH115_CONTRAST_CONTROL, ERMCH115_CONTRAST_DATA_DEFAULT,
+	ERMCH1115_IREF_REG, ERMCH1115_IREF_SET,
+	ERMCH1115_SEG_SET_REMAP, ERMCH1115_SEG_SET_PADS,
+	ERMCH1115_ENTIRE_DISPLAY_ON, ERMCH1115_DISPLAY_NORMAL,
+	ERMCH1115_MULTIPLEX_MODE_SET, ERMCH1115_MULTIPLEX_DATA_SET,
+	ERMCH1115_COMMON_SCAN_DIR,
+	ERMCH1115_OFFSET_MODE_SET, ERMCH1115_OFFSET_DATA_SET,
+	ERMCH1115_OSC_FREQ_MODE_SET, ERMCH1115_OSC_FREQ_DATA_SET,
+	ERMCH1115_PRECHARGE_MODE_SET, ERMCH1115_PRECHARGE_DATA_SET,
+	ERMCH1115_COM_LEVEL_MODE_SET, ERMCH1115_COM_LEVEL_DATA_SET,
+	ERMCH1115_SET_PUMP_REG | ERMCH115_SET_PUMP_SET,
+	ERMCH1115_DC_MODE_SET, ERMCH1115_DC_ONOFF_SET,
+	ERMCH1115_DISPLAY_ON
+};
+static constexpr uint8_t ERMCH1115_InitContrastIndex = 6; // replaced by the OLEDbegin contrast
+static_assert(ERMCH1115_InitSequence[ERMCH1115_InitContrastIndex - 1] == ERMCH115_CONTRAST_CONTROL,
+	"contrast data must follow its command");
+
+// One display runs DMA updates, used by the interrupt handler
+static ERMCH1115 * volatile oledAsyncInstance = nullptr;
+static void oledDmaIrq(void) { if (oledAsyncInstance != nullptr) oledAsyncInstance->dmaIrqHandler(); }
+
 // Class Constructor
 ERMCH1115  :: ERMCH1115(int8_t cd, int8_t rst, int8_t cs, int8_t sclk, int8_t din) :  ERMCH1115_graphics(OLED_WIDTH, OLED_HEIGHT) 
 {
@@ -42,7 +72,7 @@ void ERMCH1115::OLEDbegin (uint8_t OLEDcontrast, spi_inst_t *spiType, uint32_t s
 	gpio_set_dir(_OLED_CS, GPIO_OUT);
 	gpio_put(_OLED_CS, true);
 	
-	spi_inst_t *spi = spiType;
+	spi = spiType;
 	// Initialize SPI port 
 	spi_init(spi, spiSpeedKhz * 1000);
 	// Initialize SPI pins
@@ -65,53 +95,18 @@ void ERMCH1115::OLEDbegin (uint8_t OLEDcontrast, spi_inst_t *spiType, uint32_t s
 // Can be used to reset OLED to default values.
 void ERMCH1115::OLEDinit()
  {
+	OLEDwaitAsync();
 	ERMCH1115_CS_SetLow;
 	
 	OLEDReset();
 	
-	send_command(ERMCH1115_DISPLAY_OFF, 0); 
-	
-	send_command(ERMCH1115_SET_COLADD_LSB, 0); 
-	send_command(ERMCH1115_SET_COLADD_MSB, 0); 
-	send_command(ERMCH1115_SET_PAGEADD, 0); 
-	send_command(ERMCH115_SET_DISPLAY_START_LINE, 0); 
-   
-	send_command(ERMCH115_CONTRAST_CONTROL  ,0); 
-	send_command(_OLEDcontrast, 0);  
-	
-	send_command(ERMCH1115_IREF_REG, 0); 
-	send_command(ERMCH1115_IREF_SET, 0); 
-	
-	send_command(ERMCH1115_SEG_SET_REMAP, 0); 
-	send_command(ERMCH1115_SEG_SET_PADS, 0); 
-	send_command(ERMCH1115_ENTIRE_DISPLAY_ON, 0); 
-	send_command(ERMCH1115_DISPLAY_NORMAL, 0);
-	
-	send_command(ERMCH1115_MULTIPLEX_MODE_SET, 0); 
-	send_command(ERMCH1115_MULTIPLEX_DATA_SET , 0); 
-	
-	send_command(ERMCH1115_COMMON_SCAN_DIR, 0); 
-	
-	send_command(ERMCH1115_OFFSET_MODE_SET, 0); 
-	send_command(ERMCH1115_OFFSET_DATA_SET, 0); 
-	
-	send_command(ERMCH1115_OSC_FREQ_MODE_SET, 0); 
-	send_command(ERMCH1115_OSC_FREQ_DATA_SET, 0); 
-	
-	send_command(ERMCH1115_PRECHARGE_MODE_SET, 0); 
-	send_command(ERMCH1115_PRECHARGE_DATA_SET, 0); 
-	
-	send_command(ERMCH1115_COM_LEVEL_MODE_SET, 0); 
-	send_command(ERMCH1115_COM_LEVEL_DATA_SET, 0); 
-	
-	send_command(ERMCH1115_SET_PUMP_REG, ERMCH115_SET_PUMP_SET); 
-	
-	send_command(ERMCH1115_DC_MODE_SET, 0); 
-	send_command(ERMCH1115_DC_ONOFF_SET, 0);
-	
-	send_command(ERMCH1115_DISPLAY_ON, 0);
+	uint8_t sequence[sizeof(ERMCH1115_InitSequence)];
+	memcpy(sequence, ERMCH1115_InitSequence, sizeof(sequence));
+	sequence[ERMCH1115_InitContrastIndex] = _OLEDcontrast;
+	send_commands(sequence, sizeof(sequence));
 	_sleep= false;
 	ERMCH1115_CS_SetHigh;  
+	screenChanged(0xFF); // display RAM not known after reset
 	busy_wait_ms(ERMCH1115_INITDELAY);
 }
 
@@ -119,18 +114,43 @@ void ERMCH1115::OLEDinit()
 // Param1: the command
 // Param2: the values to change
 void ERMCH1115::send_command (uint8_t command,uint8_t value) 
+{
+  uint8_t byte = command | value;
+  send_commands(&byte, 1);
+}
+
+// Desc: Sends a run of commands to the display in one SPI write
+// Param1: the commands, Param2: number of commands
+void ERMCH1115::send_commands(const uint8_t* commands, uint8_t length)
 {
   ERMCH1115_CD_SetLow; 
-  send_data(command | value);
+  spi_write_blocking(spi, commands, length); // returns once shifted out
   ERMCH1115_CD_SetHigh;
 }
 
+// Desc: Sets the column and page the next data goes to, one SPI write
+// Param1: page 0-7, Param2: column 0-127
+void ERMCH1115::send_address(uint8_t page, uint8_t column)
+{
+  uint8_t address[3] = {
+	(uint8_t)(ERMCH1115_SET_COLADD_LSB | (column & 0x0F)),
+	(uint8_t)(ERMCH1115_SET_COLADD_MSB | ((column & 0xF0) >> 4)),
+	(uint8_t)(ERMCH1115_SET_PAGEADD | page)};
+  send_commands(address, sizeof(address));
+}
+
 // Desc: Sends data to the display via hardware SPI
 // Param1: Data byte
 void ERMCH1115::send_data(uint8_t data)
 {
 	spi_write_blocking(spi, &data, 1);
+}
 
+// Desc: Sends a run of data bytes to the display in one SPI write
+// Param1: the data, Param2: number of bytes
+void ERMCH1115::send_data(const uint8_t* data, size_t length)
+{
+	spi_write_blocking(spi, data, length);
 }
 
 // Desc: Resets OLED in a four wire setup called at start 
@@ -148,6 +168,7 @@ void ERMCH1115::OLEDReset ()
 // Param1: bits,  1  on , 0 off
 void ERMCH1115::OLEDEnable (uint8_t bits) 
 {
+	OLEDwaitAsync();
  
  ERMCH1115_CS_SetLow;
  if (bits)
@@ -173,20 +194,15 @@ bool ERMCH1115::OLEDIssleeping() { return  _sleep ;}
 // Param3: Mode. Set Scroll Mode: (28H – 2BH)  0x28 = continuous
 void ERMCH1115::OLEDscrollSetup(uint8_t Timeinterval, uint8_t Direction, uint8_t mode) 
 {
+	OLEDwaitAsync();
 
- ERMCH1115_CS_SetLow;
-
- send_command(ERMCH1115_HORIZONTAL_A_SCROLL_SETUP, 0);
- send_command(ERMCH1115_HORIZONTAL_A_SCROLL_SET_SCOL, 0);
- send_command(ERMCH1115_HORIZONTAL_A_SCROLL_SET_ECOL, 0);
+ uint8_t commands[] = {
+	ERMCH1115_HORIZONTAL_A_SCROLL_SETUP, ERMCH1115_HORIZONTAL_A_SCROLL_SET_SCOL, ERMCH1115_HORIZONTAL_A_SCROLL_SET_ECOL,
+	Direction, ERMCH1115_SPAGE_ADR_SET, Timeinterval, ERMCH1115_EPAGE_ADR_SET,
+	mode};
 
- send_command(Direction , 0);
- send_command(ERMCH1115_SPAGE_ADR_SET , 0);
- send_command(Timeinterval , 0);
- send_command(ERMCH1115_EPAGE_ADR_SET , 0);
-
- send_command(mode, 0);
-  
+ ERMCH1115_CS_SetLow;
+ send_commands(commands, sizeof(commands));
  ERMCH1115_CS_SetHigh;
  
 }
@@ -196,6 +212,7 @@ void ERMCH1115::OLEDscrollSetup(uint8_t Timeinterval, uint8_t Direction, uint8_t
 // Note OLEDscrollSetup must be called before it 
 void ERMCH1115::OLEDscroll(uint8_t bits) 
 {
+	OLEDwaitAsync();
 
 	ERMCH1115_CS_SetLow;
 	bits ? send_command(ERMCH1115_ACTIVATE_SCROLL , 0) :   send_command(ERMCH1115_DEACTIVATE_SCROLL, 0);
@@ -208,10 +225,11 @@ void ERMCH1115::OLEDscroll(uint8_t bits)
 // Note: Setup during init. 
 void ERMCH1115::OLEDContrast(uint8_t contrast)
 {
+	OLEDwaitAsync();
 
+	uint8_t commands[] = {ERMCH115_CONTRAST_CONTROL, contrast};
 	ERMCH1115_CS_SetLow;
-	send_command(ERMCH115_CONTRAST_CONTROL  ,0); 
-	send_command(contrast, 0);  
+	send_commands(commands, sizeof(commands));
 	ERMCH1115_CS_SetHigh;
 
 }
@@ -220,10 +238,13 @@ void ERMCH1115::OLEDContrast(uint8_t contrast)
 // Param1: bits 1  on , 0 off
 void ERMCH1115::OLEDFlip(uint8_t  bits) 
 {
+	OLEDwaitAsync();
 
+  uint8_t commands[] = {
+	(uint8_t)(ERMCH1115_COMMON_SCAN_DIR | (bits ? 0x08 : 0x00)), // C0H - C8H 
+	(uint8_t)(ERMCH1115_SEG_SET_REMAP | (bits ? 0x01 : 0x00))}; //(A0H - A1H)
   ERMCH1115_CS_SetLow;
-  bits ? send_command(ERMCH1115_COMMON_SCAN_DIR, 0x08):send_command(ERMCH1115_COMMON_SCAN_DIR, 0x00)  ; // C0H - C8H 
-  bits ? send_command(ERMCH1115_SEG_SET_REMAP, 0x01):   send_command(ERMCH1115_SEG_SET_REMAP, 0x00); //(A0H - A1H)
+  send_commands(commands, sizeof(commands));
   ERMCH1115_CS_SetHigh;
 
 }
@@ -239,10 +260,11 @@ void ERMCH1115::OLEDFlip(uint8_t  bits)
 // 		Default on is 0x81
 void ERMCH1115::OLEDfadeEffect(uint8_t bits) 
 {
+	OLEDwaitAsync();
 
+ uint8_t commands[] = {ERMCCH1115_BREATHEFFECT_SET, bits};
  ERMCH1115_CS_SetLow;
- send_command(ERMCCH1115_BREATHEFFECT_SET,0);
- send_command(bits,0);
+ send_commands(commands, sizeof(commands));
  ERMCH1115_CS_SetHigh;
 
 }
@@ -250,7 +272,7 @@ void ERMCH1115::OLEDfadeEffect(uint8_t bits)
 // Call when powering down
 void ERMCH1115::OLEDPowerDown(void)
 {
-	OLEDEnable(0);
+	OLEDEnable(0); // waits for a DMA update
 	ERMCH1115_CD_SetLow ;
 	ERMCH1115_RST_SetLow ;
 	ERMCH1115_CS_SetLow;
@@ -263,6 +285,7 @@ void ERMCH1115::OLEDPowerDown(void)
 // Param1: bits, 1 invert , 0 normal
 void ERMCH1115::OLEDInvert(uint8_t bits) 
 {
+	OLEDwaitAsync();
  
  ERMCH1115_CS_SetLow;
  bits ? send_command(ERMCH1115_DISPLAY_INVERT, 0) :   send_command(ERMCH1115_DISPLAY_NORMAL, 0);
@@ -286,21 +309,30 @@ void ERMCH1115::OLEDFillScreen(uint8_t dataPattern, uint8_t delay)
 // Param2: optional delay in milliseconds can be set to zero normally.
 void ERMCH1115::OLEDFillPage(uint8_t page_num, uint8_t dataPattern,uint8_t mydelay) 
 {
+	OLEDwaitAsync();
 
 	ERMCH1115_CS_SetLow;
-	send_command(ERMCH1115_SET_COLADD_LSB, 0); 
-	send_command(ERMCH1115_SET_COLADD_MSB, 0);
-	send_command(ERMCH1115_SET_PAGEADD, page_num); 
-	ERMCH1115_CS_SetHigh;
-	busy_wait_us(2);
-	ERMCH1115_CS_SetLow;
+	send_address(page_num, 0);
 	uint8_t numofbytes = OLED_WIDTH; // 128 bytes
-	for (uint8_t i = 0; i < numofbytes; i++) 
+	if (mydelay == 0)
 	{
-	  send_data(dataPattern);
-	  busy_wait_ms(mydelay);
+	  uint8_t pattern[OLED_WIDTH];
+	  memset(pattern, dataPattern, numofbytes);
+	  send_data(pattern, numofbytes);
+	} else {
+	  for (uint8_t i = 0; i < numofbytes; i++) 
+	  {
+		send_data(dataPattern);
+		busy_wait_ms(mydelay);
+	  }
 	}
 	ERMCH1115_CS_SetHigh;
+	if (page_num < OLED_PAGE_NUM)
+	{
+		memset(_screen + (OLED_WIDTH * page_num), dataPattern, OLED_WIDTH);
+		_screenKnown |= (1 << page_num);
+		markDirty(page_num, 0, OLED_WIDTH - 1); // next update puts the buffer back where it differs
+	}
 
 }
 
@@ -312,41 +344,252 @@ void ERMCH1115::OLEDFillPage(uint8_t page_num, uint8_t dataPattern,uint8_t mydel
 //Param5 the bitmap
 void ERMCH1115::OLEDBitmap(int16_t x, int16_t y, uint8_t w, uint8_t h, const uint8_t* data) 
 {
+	OLEDwaitAsync();
  ERMCH1115_CS_SetLow;
 
-  uint8_t tx, ty; 
-  uint16_t offset = 0; 
+  uint8_t ty; 
   uint8_t column = (x < 0) ? 0 : x;
   uint8_t page = (y < 0) ? 0 : y >>3;
+  uint8_t pagesWritten = 0;
+  int16_t txStart = (x < 0) ? -x : 0; // columns on screen
+  int16_t txEnd = (x + w > OLED_WIDTH) ? OLED_WIDTH - x : w;
 
   for (ty = 0; ty < h; ty = ty + 8) 
   {
 		if (y + ty < 0 || y + ty >= OLED_HEIGHT) {continue;}
-		send_command(ERMCH1115_SET_COLADD_LSB, (column & 0x0F)); 
-		send_command(ERMCH1115_SET_COLADD_MSB, (column & 0xF0) >> 4);
-		send_command(ERMCH1115_SET_PAGEADD, page++); 
-
-		for (tx = 0; tx < w; tx++) 
-		{
-			  if (x + tx < 0 || x + tx >= OLED_WIDTH) {continue;}
-			  offset = (w * (ty >> 3)) + tx; 
-			  send_data(data[offset]);
-		}
+		pagesWritten |= (1 << page);
+		send_address(page++, column);
+		if (txEnd > txStart) send_data(data + (w * (ty >> 3)) + txStart, txEnd - txStart);
   }
 ERMCH1115_CS_SetHigh;
+screenChanged(pagesWritten); // buffer no longer matches, resent whole on next update
 }
 
 //Desc: updates the buffer i.e. writes it to the screen
+//Note: Only bytes changed since the last update are sent, see collectSpans.
+// Waits for a DMA update still in flight first.
 void ERMCH1115::OLEDupdate() 
 {
-  uint8_t x = 0; uint8_t y = 0; uint8_t w = this->bufferWidth; uint8_t h = this->bufferHeight;
-  OLEDBuffer( x,  y,  w,  h, (uint8_t*) this->OLEDbuffer);
+  OLEDwaitAsync();
+  _frameStartUs = to_us_since_boot(get_absolute_time());
+  collectSpans();
+  ERMCH1115_CS_SetLow;
+  for (uint8_t i = 0; i < _spanCount; i++)
+  {
+	sendSpan(_spans[i]);
+  }
+  ERMCH1115_CS_SetHigh;
+  frameDone();
+}
+
+//Desc: sets up the DMA channel and interrupt for OLEDupdateAsync
+//Returns: bool false if no DMA channel is free, OLEDupdateAsync then sends blocking
+//Note: Call after OLEDbegin. Uses DMA_IRQ_0 as a shared handler, one display only.
+bool ERMCH1115::OLEDbeginAsync()
+{
+	if (_dmaChannel >= 0) return true;
+	int channel = dma_claim_unused_channel(false);
+	if (channel < 0) return false;
+
+	dma_channel_config config = dma_channel_get_default_config(channel);
+	channel_config_set_transfer_data_size(&config, DMA_SIZE_8);
+	channel_config_set_dreq(&config, spi_get_dreq(spi, true));
+	channel_config_set_read_increment(&config, true);
+	channel_config_set_write_increment(&config, false);
+	dma_channel_configure(channel, &config, &spi_get_hw(spi)->dr, _screen, 0, false);
+
+	_dmaChannel = channel;
+	oledAsyncInstance = this;
+	dma_channel_set_irq0_enabled(channel, true);
+	irq_add_shared_handler(DMA_IRQ_0, oledDmaIrq, PICO_SHARED_IRQ_HANDLER_DEFAULT_ORDER_PRIORITY);
+	irq_set_enabled(DMA_IRQ_0, true);
+	return true;
+}
+
+//Desc: starts writing the buffer to the screen by DMA and returns
+//Returns: bool false if DMA is not set up, the update was sent blocking
+//Note: The changed bytes are copied to a second buffer and sent from there,
+// so drawing on OLEDbuffer can go on at once. Waits if the last DMA update is
+// still in flight. The address commands of each span are written from the
+// DMA interrupt, CD low, then the span data goes by DMA with CD high,
+// chip select is held low for the whole update.
+bool ERMCH1115::OLEDupdateAsync()
+{
+	if (_dmaChannel < 0)
+	{
+		OLEDupdate();
+		return false;
+	}
+	OLEDwaitAsync();
+	_frameStartUs = to_us_since_boot(get_absolute_time());
+	if (collectSpans() == 0)
+	{
+		frameDone();
+		return true;
+	}
+	_spanNext = 0;
+	_asyncBusy = true;
+	ERMCH1115_CS_SetLow;
+	startSpan();
+	return true;
+}
+
+//Desc: OLEDIsBusy
+//Returns: bool true while a DMA update is being sent
+bool ERMCH1115::OLEDIsBusy() {return _asyncBusy;}
+
+//Desc: waits for a DMA update in flight to finish
+void ERMCH1115::OLEDwaitAsync()
+{
+	while (_asyncBusy) tight_loop_contents();
+}
+
+//Desc: OLEDgetFrameStats
+//Returns: update counters, frames done and time per frame
+const ERMCH1115_FrameStats_t& ERMCH1115::OLEDgetFrameStats() {return _frameStats;}
+
+//Desc: DMA interrupt handler, starts the next span or ends the update
+//Note: The DMA is done once the last byte is in the SPI FIFO, up to 8 bytes
+// are still shifting out before CD can go low for the next address commands.
+void ERMCH1115::dmaIrqHandler()
+{
+	if (_dmaChannel < 0 || !dma_channel_get_irq0_status(_dmaChannel)) return;
+	dma_channel_acknowledge_irq0(_dmaChannel);
+	while (spi_is_busy(spi)) tight_loop_contents();
+	if (_spanNext < _spanCount)
+	{
+		startSpan();
+		return;
+	}
+	ERMCH1115_CS_SetHigh;
+	frameDone();
+	_asyncBusy = false;
+}
+
+//Desc: Writes the address commands of the next span and starts its data by DMA
+//Note: Chip select is already low
+void ERMCH1115::startSpan()
+{
+	const ERMCH1115_Span_t &span = _spans[_spanNext++];
+	send_address(span.page, span.colStart);
+	dma_channel_transfer_from_buffer_now(_dmaChannel, _screen + (OLED_WIDTH * span.page) + span.colStart,
+		span.colEnd - span.colStart + 1);
+}
+
+//Desc: Records the time of the update just finished
+void ERMCH1115::frameDone()
+{
+	uint32_t frameUs = (uint32_t)(to_us_since_boot(get_absolute_time()) - _frameStartUs);
+	uint32_t bytes = 0;
+	for (uint8_t i = 0; i < _spanCount; i++) bytes += _spans[i].colEnd - _spans[i].colStart + 1;
+	_frameStats.frames++;
+	_frameStats.spans = _spanCount;
+	_frameStats.bytes = bytes;
+	_frameStats.lastFrameUs = frameUs;
+	if (frameUs > _frameStats.maxFrameUs) _frameStats.maxFrameUs = frameUs;
 }
 
 //Desc: clears the buffer i.e. does NOT write to the screen
 void ERMCH1115::OLEDclearBuffer()
 {
 	memset( this->OLEDbuffer, 0x00, (this->bufferWidth * (this->bufferHeight /8))  ); 
+	OLEDmarkDirty();
+}
+
+//Desc: marks the whole buffer as drawn on, for the next OLEDupdate
+//Note: Call after writing to OLEDbuffer directly or pointing it at another buffer,
+// drawing functions mark what they touch themselves.
+void ERMCH1115::OLEDmarkDirty()
+{
+	for (uint8_t page = 0; page < OLED_PAGE_NUM; page++)
+		markDirty(page, 0, OLED_WIDTH - 1);
+}
+
+// Desc: Records columns of a page drawn on since the last update
+// Param1: page 0-7
+// Param2: colStart first column, Param3: colEnd last column
+void ERMCH1115::markDirty(uint8_t page, uint8_t colStart, uint8_t colEnd)
+{
+	uint8_t bit = (1 << page);
+	if (!(_dirtyPages & bit))
+	{
+		_dirtyPages |= bit;
+		_dirtyStart[page] = colStart;
+		_dirtyEnd[page] = colEnd;
+		return;
+	}
+	if (colStart < _dirtyStart[page]) _dirtyStart[page] = colStart;
+	if (colEnd > _dirtyEnd[page]) _dirtyEnd[page] = colEnd;
+}
+
+// Desc: Lists the spans of an update and copies them to _screen
+// Returns: number of spans, also in _spanCount
+// Note: Bytes changed since the last update are found by comparing the
+// columns drawn on in each page with _screen, a short run of unchanged bytes
+// between two changes is sent rather than readdressed. Pages whose screen
+// contents are not known, after OLEDinit, OLEDBitmap or OLEDBuffer, are sent whole.
+uint8_t ERMCH1115::collectSpans()
+{
+  uint8_t pages = this->bufferHeight / 8;
+  uint8_t lastCol = (this->bufferWidth > OLED_WIDTH ? OLED_WIDTH : this->bufferWidth) - 1;
+  if (pages > OLED_PAGE_NUM) pages = OLED_PAGE_NUM;
+
+  _spanCount = 0;
+  for (uint8_t page = 0; page < pages; page++)
+  {
+	uint8_t bit = (1 << page);
+	const uint8_t* row = this->OLEDbuffer + (this->bufferWidth * page);
+	uint8_t* sent = _screen + (OLED_WIDTH * page);
+	if (!(_screenKnown & bit))
+	{
+		_spans[_spanCount++] = {page, 0, lastCol};
+		memcpy(sent, row, lastCol + 1);
+		_screenKnown |= bit;
+		continue;
+	}
+	if (!(_dirtyPages & bit)) continue;
+
+	uint8_t start = _dirtyStart[page];
+	uint8_t end = (_dirtyEnd[page] > lastCol) ? lastCol : _dirtyEnd[page];
+	uint8_t pageSpans = 0;
+	uint8_t col = start;
+	while (col <= end)
+	{
+		if (row[col] == sent[col]) {col++; continue;}
+		uint8_t spanEnd = col;
+		for (uint8_t next = col + 1; next <= end && next - spanEnd <= ERMCH1115_SPAN_GAP + 1; next++)
+		{
+			if (row[next] != sent[next]) spanEnd = next;
+		}
+		if (pageSpans == ERMCH1115_PAGE_SPANS)
+			_spans[_spanCount - 1].colEnd = spanEnd; // page full, extend its last span
+		else
+		{
+			_spans[_spanCount++] = {page, col, spanEnd};
+			pageSpans++;
+		}
+		col = spanEnd + 1;
+	}
+	if (start <= end) memcpy(sent + start, row + start, end - start + 1);
+  }
+  _dirtyPages = 0;
+  return _spanCount;
+}
+
+// Desc: Sends one span from _screen, blocking
+// Param1: span
+// Note: Called by OLEDupdate with chip select low
+void ERMCH1115::sendSpan(const ERMCH1115_Span_t &span)
+{
+	send_address(span.page, span.colStart);
+	send_data(_screen + (OLED_WIDTH * span.page) + span.colStart, span.colEnd - span.colStart + 1);
+}
+
+// Desc: Forgets the screen contents of pages written other than by OLEDupdate
+// Param1: pages, bit per page
+void ERMCH1115::screenChanged(uint8_t pages)
+{
+	_screenKnown &= ~pages;
 }
 
 //Desc: Draw a bitmap to the screen
@@ -355,32 +598,28 @@ void ERMCH1115::OLEDclearBuffer()
 //Param3: width 0-128
 //Param4 height 0-64
 //Param5 the bitmap
-//Note: Called by OLEDupdate
+//Note: Writes the screen directly, pages written are sent whole on the next OLEDupdate
 void ERMCH1115::OLEDBuffer(int16_t x, int16_t y, uint8_t w, uint8_t h, uint8_t* data) 
 {
+	OLEDwaitAsync();
  ERMCH1115_CS_SetLow;
 
-  uint8_t tx, ty; 
-  uint16_t offset = 0; 
+  uint8_t ty; 
   uint8_t column = (x < 0) ? 0 : x;
   uint8_t page = (y < 0) ? 0 : y/8;
+  uint8_t pagesWritten = 0;
+  int16_t txStart = (x < 0) ? -x : 0; // columns on screen
+  int16_t txEnd = (x + w > OLED_WIDTH) ? OLED_WIDTH - x : w;
 
   for (ty = 0; ty < h; ty = ty + 8) 
   {
 	if (y + ty < 0 || y + ty >= OLED_HEIGHT) {continue;}
-	
-	send_command(ERMCH1115_SET_COLADD_LSB, (column & 0x0F)); 
-	send_command(ERMCH1115_SET_COLADD_MSB, (column & 0XF0) >> 4); 
-	send_command(ERMCH1115_SET_PAGEADD, page++); 
- 
-	for (tx = 0; tx < w; tx++) 
-	{
-		  if (x + tx < 0 || x + tx >= OLED_WIDTH) {continue;}
-		  offset = (w * (ty /8)) + tx; 
-		  send_data(data[offset++]);
-	}
+	pagesWritten |= (1 << page);
+	send_address(page++, column);
+	if (txEnd > txStart) send_data(data + (w * (ty /8)) + txStart, txEnd - txStart);
   }
 ERMCH1115_CS_SetHigh;
+screenChanged(pagesWritten);
 
 }
 
@@ -398,7 +637,115 @@ void ERMCH1115::drawPixel(int16_t x, int16_t y, uint8_t colour)
 		case BACKGROUND:  this->OLEDbuffer[tc] &= ~(1 << (y & 7)); break;
 		case INVERSE: this->OLEDbuffer[tc] ^= (1 << (y & 7)); break;
 	  }
+	  markDirty(y >> 3, x, x);
+
+}
+
+// Desc: Draws a vertical line into the buffer a byte at a time
+// Param1: x, Param2: y, Param3: height, Param4: colour
+void ERMCH1115::drawFastVLine(int16_t x, int16_t y, int16_t h, uint8_t colour)
+{
+	fillRect(x, y, 1, h, colour);
+}
+
+// Desc: Draws a horizontal line into the buffer a byte at a time
+// Param1: x, Param2: y, Param3: width, Param4: colour
+// Note: a width under 1 draws what drawLine draws, x+w-1 back to x
+void ERMCH1115::drawFastHLine(int16_t x, int16_t y, int16_t w, uint8_t colour)
+{
+	if (w < 1) { x += w - 1; w = 2 - w; }
+	fillRect(x, y, w, 1, colour);
+}
+
+// Desc: Fills a rectangle of the buffer, whole bytes of each page with masks
+// on the first and last page, same pixels as a drawPixel per pixel
+// Param1: x, Param2: y, Param3: width, Param4: height, Param5: colour
+// Note: a height under 1 draws what the drawLine of each column draws, y+h-1 back to y
+void ERMCH1115::fillRect(int16_t x, int16_t y, int16_t w, int16_t h, uint8_t colour)
+{
+	if (w < 1) return;
+	if (h < 1) { y += h - 1; h = 2 - h; }
+	int16_t x0 = (x < 0) ? 0 : x;
+	int16_t x1 = (x + w > bufferWidth) ? bufferWidth : x + w; // one past the last column
+	int16_t y0 = (y < 0) ? 0 : y;
+	int16_t y1 = (y + h > bufferHeight) ? bufferHeight - 1 : y + h - 1; // last row
+	if (x0 >= x1 || y0 > y1) return;
+
+	for (uint8_t page = y0 >> 3; page <= (y1 >> 3); page++)
+	{
+		uint8_t mask = 0xFF;
+		if (page == (y0 >> 3)) mask &= (0xFF << (y0 & 7));
+		if (page == (y1 >> 3)) mask &= (0xFF >> (7 - (y1 & 7)));
+		uint8_t* row = this->OLEDbuffer + (bufferWidth * page);
+		switch (colour)
+		{
+			case FOREGROUND: for (int16_t col = x0; col < x1; col++) row[col] |= mask; break;
+			case BACKGROUND: for (int16_t col = x0; col < x1; col++) row[col] &= ~mask; break;
+			case INVERSE: for (int16_t col = x0; col < x1; col++) row[col] ^= mask; break;
+		}
+		markDirty(page, x0, x1 - 1);
+	}
+}
+
+// Desc: Applies a colour to some bits of a buffer byte
+// Param1: the byte, Param2: bits to change, Param3: colour
+static inline void blitBits(uint8_t &byte, uint8_t mask, uint8_t colour)
+{
+	switch (colour)
+	{
+		case FOREGROUND: byte |= mask; break;
+		case BACKGROUND: byte &= ~mask; break;
+		case INVERSE: byte ^= mask; break;
+	}
+}
 
+// Desc: Draws a character of an 8 pixel high font, each font column goes
+// into the buffer as one byte, or two shifted bytes when y is not on a page
+// Param1: x, Param2: y, Param3: character, Param4: colour, Param5: background, Param6: size
+// Note: same pixels as the graphics class drawChar, which still draws scaled text
+void ERMCH1115::drawChar(int16_t x, int16_t y, unsigned char c, uint8_t colour, uint8_t bg, uint8_t size)
+{
+	const unsigned char* font = _CurrentFont;
+	const int16_t fontWidth = _CurrentFontWidth;
+	if (size != 1 || _CurrentFontheight != OLEDFontHeight_8 || font == nullptr || (bufferHeight & 7))
+	{
+		ERMCH1115_graphics::drawChar(x, y, c, colour, bg, size);
+		return;
+	}
+	if ((x >= _width) || (y >= _height) || (x + fontWidth < 0) || (y + 7 < 0)) return;
+
+	const unsigned char* glyph = font + ((c - _CurrentFontoffset) * fontWidth);
+	int16_t colStart = (x < 0) ? 0 : x;
+	int16_t colEnd = (x + fontWidth >= bufferWidth) ? bufferWidth - 1 : x + fontWidth; // blank column included
+	if (colStart > colEnd) return;
+	int16_t page = ((y + 8) >> 3) - 1; // page of the top row, -1 above the screen
+	uint8_t shift = (y + 8) & 7;
+	int16_t pages = bufferHeight >> 3;
+	bool top = (page >= 0 && page < pages);
+	bool bottom = (shift != 0 && page + 1 < pages);
+	uint8_t topRows = 0xFF << shift;
+	uint8_t bottomRows = 0xFF >> (8 - shift);
+	uint8_t* topByte = top ? this->OLEDbuffer + (bufferWidth * page) : nullptr;
+	uint8_t* bottomByte = bottom ? this->OLEDbuffer + (bufferWidth * (page + 1)) : nullptr;
+
+	for (int16_t col = colStart; col <= colEnd; col++)
+	{
+		uint8_t line = (col - x == fontWidth) ? 0x00 : glyph[col - x];
+		if (top)
+		{
+			uint8_t bits = line << shift;
+			blitBits(topByte[col], bits, colour);
+			if (bg != colour) blitBits(topByte[col], topRows & ~bits, bg);
+		}
+		if (bottom)
+		{
+			uint8_t bits = line >> (8 - shift);
+			blitBits(bottomByte[col], bits, colour);
+			if (bg != colour) blitBits(bottomByte[col], bottomRows & ~bits, bg);
+		}
+	}
+	if (top) markDirty(page, colStart, colEnd);
+	if (bottom) markDirty(page + 1, colStart, colEnd);
 }
 
 //************** EOF *************************
@@ -22,6 +22,7 @@ ERMCH1115_graphics::ERMCH1115_graphics(int16_t w, int16_t h):
 	textbgcolor = 0xFF;
 	wrap      = true;
 	drawBitmapAddr=true;
+	_CurrentFont = pFontDefaultptr;
 }
 
 // Draw a circle outline
@@ -422,7 +423,8 @@ void ERMCH1115_graphics::drawChar(int16_t x, int16_t y, unsigned char c,
 	if((x >= _width)            || // Clip right
 		 (y >= _height)           || // Clip bottom
 		 ((x + (_CurrentFontWidth+1) * size - 1) < 0) || // Clip left
-		 ((y + _CurrentFontheight * size - 1) < 0))   // Clip top
+		 ((y + _CurrentFontheight * size - 1) < 0) || // Clip top
+		 (_CurrentFont == nullptr)) // not a font of vertical bytes
 		return;
 
 	for (int8_t i=0; i<(_CurrentFontWidth+1); i++ ) {
@@ -433,18 +435,7 @@ void ERMCH1115_graphics::drawChar(int16_t x, int16_t y, unsigned char c,
 		}
 		else 
 		{
-			 switch (_FontNumber) {
-
-				case OLEDFontType_Default : line = pFontDefaultptr[((c - _CurrentFontoffset) * _CurrentFontWidth) + i]; break;
-				case OLEDFontType_Thick : line = pFontThickptr[((c - _CurrentFontoffset) * _CurrentFontWidth) + i]; break;
-				case OLEDFontType_SevenSeg: line = pFontSevenSegptr[((c - _CurrentFontoffset) * _CurrentFontWidth) + i]; break;
-				case OLEDFontType_Wide : line = pFontWideptr[((c - _CurrentFontoffset) * _CurrentFontWidth) + i]; break;
-				case OLEDFontType_Tiny : line = pFontTinyptr[((c - _CurrentFontoffset) * _CurrentFontWidth) + i]; break;
-				case OLEDFontType_Homespun : line = pFontHomeSpunptr[((c - _CurrentFontoffset) * _CurrentFontWidth) + i]; break;
-				default: // wrong font number
-						return;
-				break;
-				}
+			line = _CurrentFont[((c - _CurrentFontoffset) * _CurrentFontWidth) + i];
 		}
 		for (int8_t j = 0; j<_CurrentFontheight; j++) {
 			if (line & 0x1) {
@@ -538,46 +529,55 @@ void ERMCH1115_graphics::setFontNum(OLEDFontType_e FontNumber)
 			_CurrentFontWidth = OLEDFontWidth_5;
 			_CurrentFontoffset =  OLEDFontOffset_Extend;
 			_CurrentFontheight = OLEDFontHeight_8;
+			_CurrentFont = pFontDefaultptr;
 		break; 
 		case OLEDFontType_Thick: // Thick 7 by 8 (NO LOWERCASE LETTERS)
 			_CurrentFontWidth = OLEDFontWidth_7;
 			_CurrentFontoffset = OLEDFontOffset_Space;
 			_CurrentFontheight = OLEDFontHeight_8;
+			_CurrentFont = pFontThickptr;
 		break; 
 		case OLEDFontType_SevenSeg:  // Seven segment 4 by 8
 			_CurrentFontWidth = OLEDFontWidth_4;
 			_CurrentFontoffset = OLEDFontOffset_Space;
 			_CurrentFontheight = OLEDFontHeight_8;
+			_CurrentFont = pFontSevenSegptr;
 		break;
 		case OLEDFontType_Wide : // Wide  8 by 8 (NO LOWERCASE LETTERS)
 			_CurrentFontWidth = OLEDFontWidth_8;
 			_CurrentFontoffset = OLEDFontOffset_Space;
 			_CurrentFontheight = OLEDFontHeight_8;
+			_CurrentFont = pFontWideptr;
 		break; 
 		case OLEDFontType_Tiny:  // tiny 3 by 8
 			_CurrentFontWidth = OLEDFontWidth_3;
 			_CurrentFontoffset =  OLEDFontOffset_Space;
 			_CurrentFontheight = OLEDFontHeight_8;
+			_CurrentFont = pFontTinyptr;
 		break;
 		case OLEDFontType_Homespun: // homespun 7 by 8 
 			_CurrentFontWidth = OLEDFontWidth_7;
 			_CurrentFontoffset = OLEDFontOffset_Space;
 			_CurrentFontheight = OLEDFontHeight_8;
+			_CurrentFont = pFontHomeSpunptr;
 		break;
 		case OLEDFontType_Bignum : // big nums 16 by 32 (NUMBERS + : only)
 			_CurrentFontWidth = OLEDFontWidth_16;
 			_CurrentFontoffset = OLEDFontOffset_Number;
 			_CurrentFontheight = OLEDFontHeight_32;
+			_CurrentFont = nullptr;
 		break; 
 		case OLEDFontType_Mednum: // med nums 16 by 16 (NUMBERS + : only)
 			_CurrentFontWidth = OLEDFontWidth_16;
 			_CurrentFontoffset =  OLEDFontOffset_Number;
 			_CurrentFontheight = OLEDFontHeight_16;
+			_CurrentFont = nullptr;
 		break;
 		default: // if wrong font num passed in,  set to default
 			_CurrentFontWidth = OLEDFontWidth_5;
 			_CurrentFontoffset =  OLEDFontOffset_Extend;
 			_CurrentFontheight = OLEDFontHeight_8;
+			_CurrentFont = pFontDefaultptr;
 			_FontNumber = OLEDFontType_Default;
 		break;
 	}
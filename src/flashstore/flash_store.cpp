@@ -0,0 +1,97 @@
+/*
+ * Project Name: Flash record store for RPI PICO
+ * File: flash_store.cpp
+ * Description: library source file, keeps one small settings record per
+ * flash sector at the top of the PICO flash, checked by magic and checksum.
+ * Toolchain :: Rpi PICO ,rp2040, SDK C++
+ * URL: https://github.com/gavinlyonsrepo/FM_Radio_PICO
+ */
+
+#include <string.h> // memcmp memcpy
+#include "../include/flashstore/flash_store.hpp"
+#include "hardware/sync.h"
+
+// Constructor
+// Param1 :: sector , 1 = last sector of flash, 2 = the one before, see FLASH_STORE_SECTOR_x
+// Param2 :: magic , identifies the record type and version, a change discards old records
+FlashStore::FlashStore(uint8_t sector, uint32_t magic) :
+	_offset(PICO_FLASH_SIZE_BYTES - (uint32_t)sector * FLASH_SECTOR_SIZE), _magic(magic) {}
+
+// Returns :: the record as mapped by XIP, header first
+const uint8_t * FlashStore::record() {
+	return (const uint8_t *)(XIP_BASE + _offset);
+}
+
+// Fletcher-16 checksum
+// Param1 :: data , Param2 :: length in bytes
+uint16_t FlashStore::checksum(const uint8_t *data, uint16_t length) {
+	uint16_t sum1 = 0;
+	uint16_t sum2 = 0;
+	for (uint16_t i = 0; i < length; i++) {
+		sum1 = (sum1 + data[i]) % 255;
+		sum2 = (sum2 + sum1) % 255;
+	}
+	return (sum2 << 8) | sum1;
+}
+
+// Check the stored record
+// Param1 :: length , bytes expected
+// Returns :: bool true if magic, length and checksum match
+bool FlashStore::isValid(uint16_t length) {
+	FlashStoreHeader header;
+	memcpy(&header, record(), sizeof(header));
+	if (header.magic != _magic || header.length != length || length > FLASH_STORE_MAX_LENGTH) return false;
+	return header.checksum == checksum(record() + sizeof(header), length);
+}
+
+// Read the stored record
+// Param1 :: data , destination, left untouched if no valid record
+// Param2 :: length , bytes to read, must match the length saved
+// Returns :: bool false if no valid record, e.g. first run or magic changed
+bool FlashStore::load(void *data, uint16_t length) {
+	if (!isValid(length)) return false;
+	memcpy(data, record() + sizeof(FlashStoreHeader), length);
+	return true;
+}
+
+// Write the record, the sector is erased first
+// Param1 :: data , Param2 :: length , up to FLASH_STORE_MAX_LENGTH bytes
+// Returns :: bool false if too long
+// Notes :: Nothing is written if the stored record is already the same, to save
+// flash wear. Interrupts are off for the erase and program, tens of mS, so
+// call from the main loop when nothing time critical is running. Code runs
+// from flash so the other core must not be running from flash either.
+bool FlashStore::save(const void *data, uint16_t length) {
+	static uint8_t page[FLASH_PAGE_SIZE];
+	const uint8_t *source = (const uint8_t *)data;
+	FlashStoreHeader header = {_magic, length, 0};
+	uint32_t total = sizeof(header) + length;
+
+	if (length > FLASH_STORE_MAX_LENGTH) return false;
+	header.checksum = checksum(source, length);
+	if (isValid(length) && memcmp(record() + sizeof(header), data, length) == 0) return true;
+
+	uint32_t interrupts = save_and_disable_interrupts();
+	flash_range_erase(_offset, FLASH_SECTOR_SIZE);
+	for (uint32_t done = 0; done < total; done += FLASH_PAGE_SIZE) {
+		// header then record, split into whole pages
+		memset(page, 0xFF, sizeof(page));
+		for (uint32_t i = 0; i < FLASH_PAGE_SIZE && (done + i) < total; i++) {
+			uint32_t position = done + i;
+			page[i] = (position < sizeof(header)) ? ((const uint8_t *)&header)[position] : source[position - sizeof(header)];
+		}
+		flash_range_program(_offset + done, page, FLASH_PAGE_SIZE);
+	}
+	restore_interrupts(interrupts);
+	return true;
+}
+
+// Erase the record, load() fails until the next save()
+void FlashStore::erase() {
+	uint32_t interrupts = save_and_disable_interrupts();
+	flash_range_erase(_offset, FLASH_SECTOR_SIZE);
+	restore_interrupts(interrupts);
+}
+
+// Returns :: byte offset of the record sector from the start of flash
+uint32_t FlashStore::getOffset() {return _offset;}
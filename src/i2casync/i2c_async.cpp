@@ -0,0 +1,284 @@
+/*
+ * Project Name: Asynchronous I2C transport for RPI PICO
+ * File: i2c_async.cpp
+ * Description: library source file, queues I2C transfers per bus and
+ * runs them from the I2C interrupt so the CPU is free while bytes move.
+ * Toolchain :: Rpi PICO ,rp2040, SDK C++
+ * URL: https://github.com/gavinlyonsrepo/FM_Radio_PICO
+ */
+
+#include "../include/i2casync/i2c_async.hpp"
+
+#ifndef I2C_ASYNC_HOST
+#include "hardware/irq.h"
+#include "hardware/sync.h"
+
+// One transport per I2C block, used by the interrupt handlers
+static I2CAsync * volatile i2cAsyncInstance[2] = {nullptr, nullptr};
+static void i2cAsyncIrq0(void) { if (i2cAsyncInstance[0] != nullptr) i2cAsyncInstance[0]->irqHandler(); }
+static void i2cAsyncIrq1(void) { if (i2cAsyncInstance[1] != nullptr) i2cAsyncInstance[1]->irqHandler(); }
+#endif
+
+// Constructor
+// Param1 :: The I2C interface i2c0 or i2c1, must be initialised by the device driver
+I2CAsync::I2CAsync(i2c_inst_t *i2c) : _i2c(i2c) {}
+
+// Install the interrupt handler for the bus
+// Notes :: Call after i2c_init. Blocking SDK calls can still be used on the
+// bus when no asynchronous transfer is in flight, see flush().
+void I2CAsync::begin() {
+#ifndef I2C_ASYNC_HOST
+	uint index = i2c_hw_index(_i2c);
+	uint irqNum = I2C0_IRQ + index;
+	i2c_get_hw(_i2c)->intr_mask = 0;
+	i2cAsyncInstance[index] = this;
+	irq_set_exclusive_handler(irqNum, index == 0 ? i2cAsyncIrq0 : i2cAsyncIrq1);
+	irq_set_enabled(irqNum, true);
+#endif
+	_started = true;
+}
+
+// Remove the interrupt handler, waits for queued transfers first
+void I2CAsync::end() {
+	if (!_started) return;
+	flush();
+#ifndef I2C_ASYNC_HOST
+	uint index = i2c_hw_index(_i2c);
+	irq_set_enabled(I2C0_IRQ + index, false);
+	irq_remove_handler(I2C0_IRQ + index, index == 0 ? i2cAsyncIrq0 : i2cAsyncIrq1);
+	i2cAsyncInstance[index] = nullptr;
+#endif
+	_started = false;
+}
+
+// Queue a write
+// Param1 :: transfer , caller owned, must stay in scope until finished
+// Param2 :: address , 7 bit device address
+// Param3 :: data , bytes to write, must stay in scope until finished
+// Param4 :: length , 1 to I2C_ASYNC_MAX_LENGTH
+// Param5 :: callback , optional, called on completion
+// Param6 :: userData , optional, passed to callback
+// Returns :: bool , false if queue full or bad length, transfer status is then error
+bool I2CAsync::submitWrite(I2CAsyncTransfer &transfer, uint8_t address, uint8_t *data, uint8_t length,
+	I2CAsyncCallback_t callback, void *userData) {
+	transfer.address = address;
+	transfer.read = false;
+	transfer.data = data;
+	transfer.length = length;
+	transfer.callback = callback;
+	transfer.userData = userData;
+	return submit(transfer);
+}
+
+// Queue a read
+// Params :: as submitWrite, data is the destination buffer
+// Returns :: bool , false if queue full or bad length, transfer status is then error
+bool I2CAsync::submitRead(I2CAsyncTransfer &transfer, uint8_t address, uint8_t *data, uint8_t length,
+	I2CAsyncCallback_t callback, void *userData) {
+	transfer.address = address;
+	transfer.read = true;
+	transfer.data = data;
+	transfer.length = length;
+	transfer.callback = callback;
+	transfer.userData = userData;
+	return submit(transfer);
+}
+
+bool I2CAsync::submit(I2CAsyncTransfer &transfer) {
+	if (transfer.length == 0 || transfer.length > I2C_ASYNC_MAX_LENGTH || transfer.data == nullptr) {
+		transfer.status = I2C_ASYNC_ERROR;
+		return false;
+	}
+#ifndef I2C_ASYNC_HOST
+	uint32_t interrupts = save_and_disable_interrupts();
+#endif
+	uint8_t next = (_tail + 1) % I2C_ASYNC_QUEUE_SIZE;
+	bool queued = (next != _head);
+	if (queued) {
+		transfer.status = I2C_ASYNC_QUEUED;
+		transfer.issued = 0;
+		transfer.received = 0;
+		_queue[_tail] = &transfer;
+		_tail = next;
+#ifndef I2C_ASYNC_HOST
+		if (_active == nullptr) startNext();
+#endif
+	} else {
+		transfer.status = I2C_ASYNC_ERROR;
+	}
+#ifndef I2C_ASYNC_HOST
+	restore_interrupts(interrupts);
+#endif
+	return queued;
+}
+
+// Wait for a transfer to finish
+// Param1 :: transfer
+// Param2 :: timeoutUs , time to wait in uS
+// Returns :: bool true if the transfer completed OK
+bool I2CAsync::wait(I2CAsyncTransfer &transfer, uint32_t timeoutUs) {
+	absolute_time_t timeout = make_timeout_time_us(timeoutUs);
+	while (transfer.isPending()) {
+		poll();
+		if (time_reached(timeout)) return false;
+	}
+	return transfer.status == I2C_ASYNC_DONE;
+}
+
+// Take a transfer off the queue, or abort it if it is on the bus
+// Param1 :: transfer , status is error afterwards, the callback is not called
+// Notes :: For a caller owned transfer that must not outlive a timed out wait.
+// The controller abort is given I2C_ASYNC_ABORT_TIMEOUT, the block is then
+// disabled and enabled again for the next transfer anyway.
+void I2CAsync::cancel(I2CAsyncTransfer &transfer) {
+#ifndef I2C_ASYNC_HOST
+	uint32_t interrupts = save_and_disable_interrupts();
+	if (_active == &transfer) {
+		i2c_hw_t *hw = i2c_get_hw(_i2c);
+		hw->intr_mask = 0;
+		hw->enable = I2C_IC_ENABLE_ABORT_BITS | I2C_IC_ENABLE_ENABLE_BITS;
+		absolute_time_t timeout = make_timeout_time_us(I2C_ASYNC_ABORT_TIMEOUT);
+		while ((hw->enable & I2C_IC_ENABLE_ABORT_BITS) && !time_reached(timeout)) tight_loop_contents();
+		(void) hw->clr_intr;
+		_active = nullptr;
+		transfer.status = I2C_ASYNC_ERROR;
+		startNext();
+	}
+#endif
+	uint8_t index = _head;
+	while (index != _tail && _queue[index] != &transfer) index = (index + 1) % I2C_ASYNC_QUEUE_SIZE;
+	if (index != _tail) {
+		// close the gap, later transfers keep their order
+		for (uint8_t next = (index + 1) % I2C_ASYNC_QUEUE_SIZE; next != _tail; next = (next + 1) % I2C_ASYNC_QUEUE_SIZE) {
+			_queue[index] = _queue[next];
+			index = next;
+		}
+		_tail = index;
+		transfer.status = I2C_ASYNC_ERROR;
+	}
+#ifndef I2C_ASYNC_HOST
+	restore_interrupts(interrupts);
+#endif
+}
+
+// Wait until every queued transfer has finished
+void I2CAsync::flush() {
+	while (isBusy()) { poll(); }
+}
+
+// Returns :: bool true if a transfer is on the bus or queued
+bool I2CAsync::isBusy() {
+	return _active != nullptr || _head != _tail;
+}
+
+// Returns :: the I2C interface of this transport
+i2c_inst_t * I2CAsync::getInstance() {return _i2c;}
+
+// Drive the transport from the main loop
+// Notes :: Nothing to do on the interrupt backend. The polled backend runs
+// the next queued transfer to completion here.
+void I2CAsync::poll() {
+#ifdef I2C_ASYNC_HOST
+	int returnValue;
+	if (_active != nullptr || _head == _tail) return;
+	_active = _queue[_head];
+	_head = (_head + 1) % I2C_ASYNC_QUEUE_SIZE;
+	_active->status = I2C_ASYNC_BUSY;
+	if (_active->read)
+		returnValue = i2c_read_timeout_us(_i2c, _active->address, _active->data, _active->length, false, I2C_ASYNC_HOST_TIMEOUT);
+	else
+		returnValue = i2c_write_timeout_us(_i2c, _active->address, _active->data, _active->length, false, I2C_ASYNC_HOST_TIMEOUT);
+	_active->issued = _active->length;
+	_active->received = _active->read ? _active->length : 0;
+	finish(returnValue == _active->length ? I2C_ASYNC_DONE : I2C_ASYNC_ERROR);
+#endif
+}
+
+// Complete the active transfer and start the next
+// Param1 :: result , done or error
+void I2CAsync::finish(I2CAsyncStatus_e result) {
+	I2CAsyncTransfer *transfer = _active;
+#ifndef I2C_ASYNC_HOST
+	i2c_get_hw(_i2c)->intr_mask = 0;
+#endif
+	_active = nullptr;
+	transfer->status = result;
+	if (transfer->callback != nullptr) transfer->callback(transfer, transfer->userData);
+#ifndef I2C_ASYNC_HOST
+	startNext();
+#endif
+}
+
+#ifndef I2C_ASYNC_HOST
+// Put the next queued transfer on the bus, called with interrupts disabled or from the handler
+void I2CAsync::startNext() {
+	i2c_hw_t *hw = i2c_get_hw(_i2c);
+	if (_head == _tail) return;
+	_active = _queue[_head];
+	_head = (_head + 1) % I2C_ASYNC_QUEUE_SIZE;
+	_active->status = I2C_ASYNC_BUSY;
+	_aborted = false;
+
+	// target address can only be changed with the block disabled
+	hw->enable = 0;
+	hw->tar = _active->address;
+	hw->enable = 1;
+	hw->rx_tl = 0;
+	(void) hw->clr_intr;
+
+	fillFifo();
+	uint32_t mask = I2C_IC_INTR_MASK_M_TX_ABRT_BITS | I2C_IC_INTR_MASK_M_STOP_DET_BITS;
+	if (_active->read) mask |= I2C_IC_INTR_MASK_M_RX_FULL_BITS;
+	if (_active->issued < _active->length) mask |= I2C_IC_INTR_MASK_M_TX_EMPTY_BITS;
+	hw->intr_mask = mask;
+}
+
+// Push data bytes or read commands into the TX FIFO, stop on the last
+void I2CAsync::fillFifo() {
+	i2c_hw_t *hw = i2c_get_hw(_i2c);
+	while (_active->issued < _active->length && i2c_get_write_available(_i2c) > 0) {
+		uint8_t index = _active->issued++;
+		uint32_t command = _active->read ? I2C_IC_DATA_CMD_CMD_BITS : _active->data[index];
+		if (_active->issued == _active->length) command |= I2C_IC_DATA_CMD_STOP_BITS;
+		hw->data_cmd = command;
+	}
+}
+
+// I2C interrupt handler, moves bytes and completes the transfer on STOP
+void I2CAsync::irqHandler() {
+	i2c_hw_t *hw = i2c_get_hw(_i2c);
+	uint32_t status = hw->intr_stat;
+
+	if (_active == nullptr) {
+		hw->intr_mask = 0;
+		(void) hw->clr_intr;
+		return;
+	}
+	if (status & I2C_IC_INTR_STAT_R_TX_ABRT_BITS) {
+		// FIFO is flushed by the abort, controller still sends STOP
+		(void) hw->clr_tx_abrt;
+		_aborted = true;
+		hw->intr_mask &= ~I2C_IC_INTR_MASK_M_TX_EMPTY_BITS;
+	}
+	if (_active->read) {
+		while (hw->rxflr > 0 && _active->received < _active->length)
+			_active->data[_active->received++] = (uint8_t) hw->data_cmd;
+	}
+	if ((status & I2C_IC_INTR_STAT_R_TX_EMPTY_BITS) && !_aborted) {
+		fillFifo();
+		if (_active->issued == _active->length)
+			hw->intr_mask &= ~I2C_IC_INTR_MASK_M_TX_EMPTY_BITS;
+	}
+	if (status & I2C_IC_INTR_STAT_R_STOP_DET_BITS) {
+		(void) hw->clr_stop_det;
+		if (_aborted || (_active->read && _active->received < _active->length))
+			finish(I2C_ASYNC_ERROR);
+		else
+			finish(I2C_ASYNC_DONE);
+	}
+}
+#else
+void I2CAsync::startNext() {}
+void I2CAsync::fillFifo() {}
+void I2CAsync::irqHandler() {}
+#endif
@@ -0,0 +1,276 @@
+/*
+ * Project Name: I2C bus backends for RPI PICO
+ * File: i2c_bus.cpp
+ * Description: library source file, bus backends the device drivers are
+ * templated on
+ * Toolchain :: Rpi PICO ,rp2040, SDK C++
+ * URL: https://github.com/gavinlyonsrepo/FM_Radio_PICO
+ */
+
+#include <string.h>
+#include "../include/i2cbus/i2c_bus.hpp"
+
+// === I2CHardwareBus ===
+
+// Initialise the I2C block
+// Param1 :: The I2C interface i2c0 or i2c1, stored for the transfers
+// Param2 :: The I2C Data pin SDA
+// Param3 :: The I2C clock pin SCLK
+// Param4 :: The I2C bus clock speed in Khz , max 400.
+void I2CHardwareBus::init(i2c_inst_t *i2c, uint8_t sdata, uint8_t sclk, uint16_t clockspeed) {
+	_i2c = i2c;
+	i2c_init(_i2c, clockspeed * 1000);
+	gpio_set_function(sdata, GPIO_FUNC_I2C);
+	gpio_set_function(sclk, GPIO_FUNC_I2C);
+	gpio_pull_up(sdata);
+	gpio_pull_up(sclk);
+}
+
+void I2CHardwareBus::deinit() {i2c_deinit(_i2c);}
+
+int I2CHardwareBus::write(uint8_t address, const uint8_t *src, size_t len, uint32_t timeoutUs) {
+	return i2c_write_timeout_us(_i2c, address, src, len, false, timeoutUs);
+}
+
+int I2CHardwareBus::read(uint8_t address, uint8_t *dst, size_t len, uint32_t timeoutUs) {
+	return i2c_read_timeout_us(_i2c, address, dst, len, false, timeoutUs);
+}
+
+// Returns :: the I2C interface set by init
+i2c_inst_t * I2CHardwareBus::getInstance() {return _i2c;}
+
+// === I2CAsyncBus ===
+
+// Set the transfer queue, call before init
+// Param1 :: queue for the I2C block the device is on
+void I2CAsyncBus::setQueue(I2CAsync *queue) {_queue = queue;}
+
+// Initialise the I2C block of the queue and start the queue
+// Param1 :: unused, the queue's I2C interface is used
+// Params :: as I2CHardwareBus::init
+void I2CAsyncBus::init(i2c_inst_t *, uint8_t sdata, uint8_t sclk, uint16_t clockspeed) {
+	if (_queue == nullptr) return;
+	i2c_init(_queue->getInstance(), clockspeed * 1000);
+	gpio_set_function(sdata, GPIO_FUNC_I2C);
+	gpio_set_function(sclk, GPIO_FUNC_I2C);
+	gpio_pull_up(sdata);
+	gpio_pull_up(sclk);
+	_queue->begin();
+}
+
+void I2CAsyncBus::deinit() {
+	if (_queue == nullptr) return;
+	_queue->end();
+	i2c_deinit(_queue->getInstance());
+}
+
+int I2CAsyncBus::write(uint8_t address, const uint8_t *src, size_t len, uint32_t timeoutUs) {
+	I2CAsyncTransfer transfer;
+	if (_queue == nullptr) return PICO_ERROR_GENERIC;
+	_queue->submitWrite(transfer, address, const_cast<uint8_t *>(src), len);
+	return this->transfer(transfer, len, timeoutUs);
+}
+
+int I2CAsyncBus::read(uint8_t address, uint8_t *dst, size_t len, uint32_t timeoutUs) {
+	I2CAsyncTransfer transfer;
+	if (_queue == nullptr) return PICO_ERROR_GENERIC;
+	_queue->submitRead(transfer, address, dst, len);
+	return this->transfer(transfer, len, timeoutUs);
+}
+
+// Wait for a queued transfer, it lives on the stack so it must be off the
+// queue before return, on timeout it is cancelled
+// Returns :: len , PICO_ERROR_TIMEOUT or PICO_ERROR_GENERIC as the SDK calls
+int I2CAsyncBus::transfer(I2CAsyncTransfer &transfer, size_t len, uint32_t timeoutUs) {
+	if (_queue->wait(transfer, timeoutUs)) return (int)len;
+	if (!transfer.isPending()) return PICO_ERROR_GENERIC;
+	_queue->cancel(transfer);
+	return PICO_ERROR_TIMEOUT;
+}
+
+// Returns :: the transfer queue, for drivers that also run asynchronous transfers
+I2CAsync * I2CAsyncBus::getQueue() {return _queue;}
+
+// === I2CBitBangBus ===
+
+// Set up the two GPIO, both released high
+// Param1 :: unused
+// Param2 :: Data pin SDA, Param3 :: Clock pin SCLK
+// Param4 :: clock speed in Khz, the half period is rounded to whole uS
+void I2CBitBangBus::init(i2c_inst_t *, uint8_t sdata, uint8_t sclk, uint16_t clockspeed) {
+	_sda = sdata;
+	_scl = sclk;
+	if (clockspeed == 0) clockspeed = I2C_BITBANG_DEFAULT_KHZ;
+	_halfPeriodUs = (500 + clockspeed - 1) / clockspeed;
+	gpio_init(_sda);
+	gpio_init(_scl);
+	gpio_pull_up(_sda);
+	gpio_pull_up(_scl);
+	gpio_put(_sda, false); // output level is always low, direction drives the line
+	gpio_put(_scl, false);
+	sdaRelease();
+	gpio_set_dir(_scl, GPIO_IN);
+}
+
+void I2CBitBangBus::deinit() {
+	sdaRelease();
+	gpio_set_dir(_scl, GPIO_IN);
+}
+
+void I2CBitBangBus::sdaRelease() {gpio_set_dir(_sda, GPIO_IN);}
+
+void I2CBitBangBus::sdaLow() {gpio_set_dir(_sda, GPIO_OUT);}
+
+void I2CBitBangBus::sclLow() {gpio_set_dir(_scl, GPIO_OUT);}
+
+// Release the clock and wait while a device stretches it
+// Returns :: bool false on timeout
+bool I2CBitBangBus::sclRelease() {
+	gpio_set_dir(_scl, GPIO_IN);
+	while (!gpio_get(_scl)) {
+		if (time_reached(_deadline)) return false;
+	}
+	busy_wait_us(_halfPeriodUs);
+	return true;
+}
+
+bool I2CBitBangBus::start() {
+	sdaRelease();
+	if (!sclRelease()) return false;
+	sdaLow();
+	busy_wait_us(_halfPeriodUs);
+	sclLow();
+	busy_wait_us(_halfPeriodUs);
+	return true;
+}
+
+void I2CBitBangBus::stop() {
+	sdaLow();
+	busy_wait_us(_halfPeriodUs);
+	sclRelease();
+	sdaRelease();
+	busy_wait_us(_halfPeriodUs);
+}
+
+// Returns :: bool true if the byte was acknowledged
+bool I2CBitBangBus::writeByte(uint8_t data) {
+	for (uint8_t mask = 0x80; mask != 0; mask >>= 1) {
+		if (data & mask) sdaRelease(); else sdaLow();
+		busy_wait_us(_halfPeriodUs);
+		if (!sclRelease()) return false;
+		sclLow();
+	}
+	sdaRelease();
+	busy_wait_us(_halfPeriodUs);
+	if (!sclRelease()) return false;
+	bool ack = !gpio_get(_sda);
+	sclLow();
+	return ack;
+}
+
+// Param2 :: ack , true to acknowledge, false on the last byte
+// Returns :: bool false on timeout
+bool I2CBitBangBus::readByte(uint8_t &data, bool ack) {
+	data = 0;
+	sdaRelease();
+	for (uint8_t bit = 0; bit < 8; bit++) {
+		busy_wait_us(_halfPeriodUs);
+		if (!sclRelease()) return false;
+		data = (data << 1) | (gpio_get(_sda) ? 1 : 0);
+		sclLow();
+	}
+	if (ack) sdaLow();
+	busy_wait_us(_halfPeriodUs);
+	if (!sclRelease()) return false;
+	sclLow();
+	sdaRelease();
+	return true;
+}
+
+int I2CBitBangBus::write(uint8_t address, const uint8_t *src, size_t len, uint32_t timeoutUs) {
+	int result = (int)len;
+	_deadline = make_timeout_time_us(timeoutUs);
+	if (!start()) return PICO_ERROR_TIMEOUT;
+	if (!writeByte(address << 1)) {
+		result = PICO_ERROR_GENERIC;
+	} else {
+		for (size_t i = 0; i < len; i++) {
+			if (!writeByte(src[i])) {
+				result = time_reached(_deadline) ? PICO_ERROR_TIMEOUT : PICO_ERROR_GENERIC;
+				break;
+			}
+		}
+	}
+	stop();
+	return result;
+}
+
+int I2CBitBangBus::read(uint8_t address, uint8_t *dst, size_t len, uint32_t timeoutUs) {
+	int result = (int)len;
+	_deadline = make_timeout_time_us(timeoutUs);
+	if (!start()) return PICO_ERROR_TIMEOUT;
+	if (!writeByte((address << 1) | 1)) {
+		result = PICO_ERROR_GENERIC;
+	} else {
+		for (size_t i = 0; i < len; i++) {
+			if (!readByte(dst[i], i + 1 < len)) {
+				result = PICO_ERROR_TIMEOUT;
+				break;
+			}
+		}
+	}
+	stop();
+	return result;
+}
+
+// === I2CMockBus ===
+
+// Param1 :: handler , called for each transfer, nullptr = accept all
+// Param2 :: userData , passed to handler
+void I2CMockBus::setHandler(I2CMockHandler_t handler, void *userData) {
+	_handler = handler;
+	_userData = userData;
+}
+
+void I2CMockBus::init(i2c_inst_t *, uint8_t, uint8_t, uint16_t) {resetCounts();}
+
+void I2CMockBus::deinit() {}
+
+int I2CMockBus::write(uint8_t address, const uint8_t *src, size_t len, uint32_t) {
+	int result = (int)len;
+	_writes++;
+	_lastWriteLen = (len > I2C_MOCK_LOG_SIZE) ? I2C_MOCK_LOG_SIZE : len;
+	memcpy(_lastWrite, src, _lastWriteLen);
+	if (_handler != nullptr) result = _handler(_userData, address, false, const_cast<uint8_t *>(src), len);
+	if (result > 0) _bytes += result;
+	return result;
+}
+
+int I2CMockBus::read(uint8_t address, uint8_t *dst, size_t len, uint32_t) {
+	int result = (int)len;
+	_reads++;
+	if (_handler != nullptr) result = _handler(_userData, address, true, dst, len);
+	else memset(dst, 0, len);
+	if (result > 0) _bytes += result;
+	return result;
+}
+
+uint32_t I2CMockBus::getWrites() {return _writes;}
+
+uint32_t I2CMockBus::getReads() {return _reads;}
+
+uint32_t I2CMockBus::getBytes() {return _bytes;}
+
+// Param1 :: len , set to the bytes kept, at most I2C_MOCK_LOG_SIZE
+// Returns :: the start of the last write
+const uint8_t * I2CMockBus::getLastWrite(size_t &len) {
+	len = _lastWriteLen;
+	return _lastWrite;
+}
+
+void I2CMockBus::resetCounts() {
+	_writes = 0;
+	_reads = 0;
+	_bytes = 0;
+	_lastWriteLen = 0;
+}
@@ -9,64 +9,102 @@
  * URL: https://github.com/gavinlyonsrepo/TEA5767_PICO
  */
 
+#include <string.h> // memcmp memcpy
 #include "../include/tea5767/tea5767.hpp"
+#include "hardware/irq.h"
 
-TEA5767N::TEA5767N() {
+// ADC level the chip search stops at for each SSL[1:0] setting
+static const uint8_t TEA5767_stopLevels[4] = {5, 5, 7, 10};
+
+// SWPORT1 ready pins, shared by every radio and bus backend
+static volatile uint32_t * volatile TEA5767_readyEdges[TEA5767_READY_PIN_COUNT] = {};
+static uint32_t TEA5767_readyEvents[TEA5767_READY_PIN_COUNT] = {};
+static uint32_t TEA5767_readyMask = 0;
+
+// GPIO interrupt, counts the ready edge of each registered pin
+static void TEA5767_ReadyIrq(void) {
+	for (uint gpio = 0; gpio < TEA5767_READY_PIN_COUNT; gpio++) {
+		if (TEA5767_readyEdges[gpio] == nullptr) continue;
+		if (gpio_get_irq_event_mask(gpio) & TEA5767_readyEvents[gpio]) {
+			gpio_acknowledge_irq(gpio, TEA5767_readyEvents[gpio]);
+			(*TEA5767_readyEdges[gpio])++;
+		}
+	}
+}
+
+// Claim the raw GPIO interrupt for the ready pins only, the default
+// dispatcher keeps the callbacks of every other pin
+// Param1 :: mask , bit per ready pin, 0 removes the handler
+static void TEA5767_SetReadyMask(uint32_t mask) {
+	if (TEA5767_readyMask != 0) gpio_remove_raw_irq_handler_masked(TEA5767_readyMask, TEA5767_ReadyIrq);
+	TEA5767_readyMask = mask;
+	if (mask != 0) gpio_add_raw_irq_handler_masked(mask, TEA5767_ReadyIrq);
+}
+
+template <class Bus>
+TEA5767N_T<Bus>::TEA5767N_T() {
   initializeTransmissionData();
   muted = false;
+  frequency = 0;
+  hiInjection = 1;
+  clearInjectionCache();
 }
 
 // Initialize the I2C setup 
 // Param1 :: the I2C address 0x60 for this device
-// Param2 :: The I2C interface i2c0 or ic21
+// Param2 :: The I2C interface i2c0 or ic21, stored in the bus backend
 // Param3 :: The I2C Data pin SDA
 // Param4 :: The I2C clock pin SCLK
 // Param5 :: The I2C bus clock speed in Khz , max 400.
-void TEA5767N::begin(uint8_t i2cAddress, i2c_inst_t* i2c_type, uint8_t SDApin, uint8_t SCLKpin, uint16_t CLKspeed) {
+template <class Bus>
+void TEA5767N_T<Bus>::begin(uint8_t i2cAddress, i2c_inst_t* i2c_type, uint8_t SDApin, uint8_t SCLKpin, uint16_t CLKspeed) {
  
 	_i2cAddress = i2cAddress;
-	i2c_inst_t *i2c = i2c_type;
-	i2c_init(i2c, CLKspeed * 1000);
-	gpio_set_function(SDApin, GPIO_FUNC_I2C);
-	gpio_set_function(SCLKpin, GPIO_FUNC_I2C);
-	gpio_pull_up(SDApin);
-	gpio_pull_up(SCLKpin);
-	
+	transmittedValid = false;
+	bus.init(i2c_type, SDApin, SCLKpin, CLKspeed);
 }
 
 // Switch off the  I2C
-// Param1 :: The I2C interface i2c0 or ic21
-void TEA5767N::deinitI2C(i2c_inst_t* i2c_type)
+template <class Bus>
+void TEA5767N_T<Bus>::deinitI2C()
 {
-	i2c_inst_t *i2c = i2c_type;
-	i2c_deinit(i2c); 	
+	bus.deinit();
 }
 
+// Returns :: the bus backend, e.g. to set up a mock or queue before begin()
+template <class Bus>
+Bus& TEA5767N_T<Bus>::getBus() {return bus;}
+
 // Check Connection Function
 // Check if TEA5767 is on the bus asks for one byte
 // Returns int16_t if less than zero = error 
-int16_t TEA5767N::CheckConnection()
+template <class Bus>
+int16_t TEA5767N_T<Bus>::CheckConnection()
 {
 	int16_t returnValue;
 	uint8_t rxdata;
-	returnValue = i2c_read_blocking(i2c, TEA5767_I2C_ADDRESS , &rxdata, 1, false);
+	returnValue = bus.read(TEA5767_I2C_ADDRESS, &rxdata, 1, TEA5767_I2C_DELAY);
 	if (bdebug) printf("CheckConnection %d , %u \r\n ", returnValue , rxdata);
 	return returnValue;
 }
 
-bool TEA5767N::GetIsConnected(void)
+template <class Bus>
+bool TEA5767N_T<Bus>::GetIsConnected(void)
 {return isConnected;}
 	  
 	  
-void TEA5767N::SetIsConnected(bool connected)
+template <class Bus>
+void TEA5767N_T<Bus>::SetIsConnected(bool connected)
 {isConnected = connected;}
 
 // Set the debug mode
 // Param1  : bool : true debug on ,false debug off.
 // Debug mode uses printf to send messages to console.
-void TEA5767N::setDebug(bool OnOff){ bdebug = OnOff;}
+template <class Bus>
+void TEA5767N_T<Bus>::setDebug(bool OnOff){ bdebug = OnOff;}
 
-void TEA5767N::initializeTransmissionData() {
+template <class Bus>
+void TEA5767N_T<Bus>::initializeTransmissionData() {
   transmission_data[FIRST_DATA] = 0;            //MUTE: 0 - not muted
                                                 //SEARCH MODE: 0 - not in search mode
 	
@@ -95,107 +133,578 @@ void TEA5767N::initializeTransmissionData() {
                                                 //DTC: 0 - the de-emphasis time constant is 50 ms
 }
 
-void TEA5767N::calculateOptimalHiLoInjection(float freq) {
+template <class Bus>
+void TEA5767N_T<Bus>::calculateOptimalHiLoInjection(uint32_t freq) {
 	uint8_t signalHigh;
 	uint8_t signalLow;
 	
+	probing = true;
+	injectionProbes++;
 	setHighSideLOInjection();
-	transmitFrequency((float) (freq + 0.45));
+	transmitFrequency(freq + 450);
 	
 	signalHigh = getSignalLevel();
 	
 	setLowSideLOInjection();
-	transmitFrequency((float) (freq - 0.45));
+	transmitFrequency(freq - 450);
 	
 	signalLow = getSignalLevel();
 
 	hiInjection = (signalHigh < signalLow) ? 1 : 0;
+	probing = false;
+}
+
+// Look up the injection side of a frequency in the cache
+// Param1 :: freq kHz
+// Returns :: bool true if found and still valid, hiInjection is then set
+template <class Bus>
+bool TEA5767N_T<Bus>::lookupInjection(uint32_t freq) {
+	int16_t channel = TEA5767_NearestChannel(freq);
+	if (channel < 0) return false;
+	TEA5767_InjectionEntry_t &entry = injectionCache[channel % TEA5767_INJECTION_CACHE_SIZE];
+	if (entry.channel != channel) return false;
+	if ((to_ms_since_boot(get_absolute_time()) - entry.timeStamp) > injectionMaxAge) {
+		entry.channel = -1;
+		return false;
+	}
+	hiInjection = entry.hiInjection;
+	injectionHits++;
+	return true;
+}
+
+// Store the current injection side of a frequency in the cache
+// Param1 :: freq kHz
+template <class Bus>
+void TEA5767N_T<Bus>::storeInjection(uint32_t freq) {
+	int16_t channel = TEA5767_NearestChannel(freq);
+	if (channel < 0) return;
+	TEA5767_InjectionEntry_t &entry = injectionCache[channel % TEA5767_INJECTION_CACHE_SIZE];
+	entry.channel = channel;
+	entry.hiInjection = hiInjection;
+	entry.level = TEA5767_INJECTION_NO_LEVEL;
+	entry.timeStamp = to_ms_since_boot(get_absolute_time());
+}
+
+// Check a level read on the tuned channel against its cache entry
+// Param1 :: level read from the module
+// Notes :: First read records the level, a later drop of injectionLevelDrop
+// or more invalidates the entry so the next tune probes again.
+template <class Bus>
+void TEA5767N_T<Bus>::checkInjectionLevel(uint8_t level) {
+	int16_t channel = TEA5767_NearestChannel(frequency);
+	if (probing || settling || seekState != TEA5767_SEEK_IDLE || channel < 0) return;
+	TEA5767_InjectionEntry_t &entry = injectionCache[channel % TEA5767_INJECTION_CACHE_SIZE];
+	if (entry.channel != channel) return;
+	if (entry.level == TEA5767_INJECTION_NO_LEVEL || level > entry.level) {
+		entry.level = level;
+	} else if ((entry.level - level) >= injectionLevelDrop) {
+		if (bdebug) printf("Injection cache invalidated, level drop %u \r\n", entry.level - level);
+		entry.channel = -1;
+	}
 }
 
-void TEA5767N::setFrequency(float _frequency) {
+// Configure the injection cache
+// Param1 :: maxAgeMs , age after which a channel is probed again
+// Param2 :: levelDrop , level drop on a tuned channel that invalidates its entry, 0 = never
+template <class Bus>
+void TEA5767N_T<Bus>::setInjectionCache(uint32_t maxAgeMs, uint8_t levelDrop) {
+	injectionMaxAge = maxAgeMs;
+	injectionLevelDrop = (levelDrop == 0) ? 0xFF : levelDrop;
+}
+
+// Empty the injection cache, every channel is probed again on next tune
+template <class Bus>
+void TEA5767N_T<Bus>::clearInjectionCache() {
+	for (uint8_t i = 0; i < TEA5767_INJECTION_CACHE_SIZE; i++)
+		injectionCache[i].channel = -1;
+}
+
+// Returns :: uint32_t number of injection probes done
+template <class Bus>
+uint32_t TEA5767N_T<Bus>::getInjectionProbes() {return injectionProbes;}
+
+// Returns :: uint32_t number of tunes that used a cached injection side
+template <class Bus>
+uint32_t TEA5767N_T<Bus>::getInjectionHits() {return injectionHits;}
+
+// PLL words for every 50 kHz channel from 76 to 108 MHz, both injection sides,
+// built at compile time and stored in flash.
+struct TEA5767_PLLTable_t
+{
+	uint16_t high[TEA5767_CHANNEL_COUNT]{};
+	uint16_t low[TEA5767_CHANNEL_COUNT]{};
+};
+
+static constexpr TEA5767_PLLTable_t TEA5767_MakePLLTable()
+{
+	TEA5767_PLLTable_t table{};
+	for (uint16_t channel = 0; channel < TEA5767_CHANNEL_COUNT; channel++) {
+		table.high[channel] = TEA5767_PLLWord(TEA5767_ChannelToKHz(channel), true);
+		table.low[channel] = TEA5767_PLLWord(TEA5767_ChannelToKHz(channel), false);
+	}
+	return table;
+}
+
+static constexpr TEA5767_PLLTable_t pllTable = TEA5767_MakePLLTable();
+static_assert(pllTable.high[TEA5767_Channel(98400)] == 12039, "PLL table high side");
+static_assert(TEA5767_PLLToKHz(pllTable.low[TEA5767_Channel(87500)], false) == 87500, "PLL table low side");
+
+// Get the PLL word for a frequency
+// Param1 :: kHz frequency
+// Param2 :: hiSide true high side injection, false low side
+// Returns :: PLL word, from the table if on the 50 kHz raster, else calculated
+template <class Bus>
+uint16_t TEA5767N_T<Bus>::getPLLWord(uint32_t kHz, bool hiSide) {
+	int16_t channel = TEA5767_Channel(kHz);
+	if (channel < 0) return TEA5767_PLLWord(kHz, hiSide);
+	return hiSide ? pllTable.high[channel] : pllTable.low[channel];
+}
+
+template <class Bus>
+void TEA5767N_T<Bus>::setFrequency(uint32_t _frequency) {
 	frequency = _frequency;
-	unsigned int frequencyW;
+	uint16_t frequencyW;
 	
 	if (hiInjection) {
 		setHighSideLOInjection();
-		frequencyW = 4 * ((frequency * 1000000) + 225000) / 32768;
 	} else {
 		setLowSideLOInjection();
-		frequencyW = 4 * ((frequency * 1000000) - 225000) / 32768;
 	}
+	frequencyW = getPLLWord(frequency, hiInjection);
 	
 	transmission_data[FIRST_DATA] = ((transmission_data[FIRST_DATA] & 0xC0) | ((frequencyW >> 8) & 0x3F));
 	transmission_data[SECOND_DATA] = frequencyW & 0XFF;
 }
 
-void TEA5767N::transmitData() {
-	
+// Send transmission data to module if it has changed since the last write
+// Notes :: Inside a beginTransaction()/endTransaction() block the data is
+// only marked dirty and is sent once by endTransaction().
+template <class Bus>
+void TEA5767N_T<Bus>::transmitData() {
+	if (transactionDepth > 0) {
+		transmissionDirty = true;
+		return;
+	}
+	if (transmittedValid && memcmp(transmitted_data, transmission_data, 5) == 0) {
+		if (bdebug) printf(" tx skipped, no change \r\n");
+		return;
+	}
+	TEA5767_Settle_e policy = settleNeeded();
+	readyMark = readyEdges;
+	if (writeRegisters() == 5) settle(policy);
+}
+
+// Work out the settle a write of the transmission data needs
+// Returns :: ready flag policy if the PLL word, injection side, band, crystal
+// or wake from standby change, none going into standby, otherwise the short settle
+template <class Bus>
+TEA5767_Settle_e TEA5767N_T<Bus>::settleNeeded() {
+	if (transmission_data[FOURTH_DATA] & 0b01000000) return TEA5767_SETTLE_NONE; // standby, nothing to wait for
+	if (!transmittedValid) return TEA5767_SETTLE_READY;
+	if (((transmitted_data[FIRST_DATA] ^ transmission_data[FIRST_DATA]) & 0x3F) ||
+		transmitted_data[SECOND_DATA] != transmission_data[SECOND_DATA] ||
+		((transmitted_data[THIRD_DATA] ^ transmission_data[THIRD_DATA]) & 0b00010000) ||
+		((transmitted_data[FOURTH_DATA] ^ transmission_data[FOURTH_DATA]) & 0b01110000) ||
+		((transmitted_data[FIFTH_DATA] ^ transmission_data[FIFTH_DATA]) & 0b10000000))
+		return TEA5767_SETTLE_READY;
+	return TEA5767_SETTLE_SHORT;
+}
+
+// Wait for the module after a register write
+// Param1 :: policy , see TEA5767_Settle_e
+// Notes :: The ready flag policy reads the status until the flag is set or
+// the deadline passes, the status read is then fresh for the caller.
+template <class Bus>
+void TEA5767N_T<Bus>::settle(TEA5767_Settle_e policy) {
+	switch (policy)
+	{
+		case TEA5767_SETTLE_NONE: break;
+		case TEA5767_SETTLE_SHORT:
+			settleStats.shortCount++;
+			busy_wait_ms(settleShortMs);
+		break;
+		case TEA5767_SETTLE_READY:
+		{
+			absolute_time_t start = get_absolute_time();
+			absolute_time_t deadline = make_timeout_time_ms(settleTimeoutMs);
+			bool ready = false;
+			settling = true;
+			if (readyPin != TEA5767_READY_PIN_NONE) {
+				// wait for the SWPORT1 edge, one read then refreshes the status
+				while (readyEdges == readyMark && !time_reached(deadline)) tight_loop_contents();
+				ready = (readRegisters() == 5) && status.ready;
+			} else {
+				while (true) {
+					busy_wait_ms(settlePollMs);
+					ready = (readRegisters() == 5) && status.ready;
+					if (ready || time_reached(deadline)) break;
+				}
+			}
+			settling = false;
+			uint32_t elapsed = (uint32_t)absolute_time_diff_us(start, get_absolute_time());
+			if (!ready) settleStats.timeouts++;
+			settleStats.count++;
+			settleStats.lastUs = elapsed;
+			settleStats.totalUs += elapsed;
+			if (elapsed < settleStats.minUs) settleStats.minUs = elapsed;
+			if (elapsed > settleStats.maxUs) settleStats.maxUs = elapsed;
+			if (bdebug) printf(" settle %lu uS %s \r\n", (unsigned long)elapsed, ready ? "ready" : "timeout");
+			// level read at the end of the settle belongs to the new station
+			if (ready) checkInjectionLevel(status.level);
+		}
+		break;
+	}
+}
+
+// Configure the settle policy
+// Param1 :: shortMs , wait after mute and option changes
+// Param2 :: pollMs , ready flag poll interval after a retune, 1 minimum
+// Param3 :: timeoutMs , deadline for the ready flag after a retune
+template <class Bus>
+void TEA5767N_T<Bus>::setSettle(uint16_t shortMs, uint16_t pollMs, uint16_t timeoutMs) {
+	settleShortMs = shortMs;
+	settlePollMs = (pollMs == 0) ? 1 : pollMs;
+	settleTimeoutMs = timeoutMs;
+}
+
+// Returns :: statistics of how long the module took to settle
+template <class Bus>
+const TEA5767_SettleStats_t& TEA5767N_T<Bus>::getSettleStats() {return settleStats;}
+
+// Clear the settle statistics
+template <class Bus>
+void TEA5767N_T<Bus>::resetSettleStats() {
+	settleStats = {0, 0, 0, 0xFFFFFFFF, 0, 0, 0};
+}
+
+// Start a batch of setter calls, the module is written once by endTransaction()
+// Notes :: May be nested, only the outermost endTransaction() writes.
+template <class Bus>
+void TEA5767N_T<Bus>::beginTransaction() {
+	transactionDepth++;
+}
+
+// End a batch of setter calls started by beginTransaction()
+// Returns :: bool , true if the module was written
+template <class Bus>
+bool TEA5767N_T<Bus>::endTransaction() {
+	if (transactionDepth == 0) return false;
+	if (--transactionDepth > 0) return false;
+	if (!transmissionDirty) return false;
+	transmissionDirty = false;
+	if (transmittedValid && memcmp(transmitted_data, transmission_data, 5) == 0) return false;
+	transmitData();
+	return true;
+}
+
+// Forget the last written data, next transmitData() always writes
+// Use if the module may have lost its registers e.g. power cycle.
+template <class Bus>
+void TEA5767N_T<Bus>::invalidateTransmission() {
+	transmittedValid = false;
+}
+
+// Write the five transmission bytes to the module, no settle delay
+// Returns int16_t the I2C return value, less than zero = error
+template <class Bus>
+int16_t TEA5767N_T<Bus>::writeRegisters() {
 	int16_t returnValue = 0;
-	returnValue =i2c_write_timeout_us(i2c, _i2cAddress, transmission_data, 5 ,false, TEA5767_I2C_DELAY);
-	//returnValue = i2c_write_blocking(i2c, _i2cAddress, transmission_data, 5 ,false); // alternative
+	asyncIdle();
+	returnValue = bus.write(_i2cAddress, transmission_data, 5, TEA5767_I2C_DELAY);
 	if (bdebug) printf(" tx return value %d \r\n", returnValue);
-	busy_wait_ms(100);
+	recordTransmission(transmission_data, returnValue);
+	return returnValue;
 }
 
-void TEA5767N::mute() {
+// Update the record of the last bytes written to the module
+// Param1 :: data , the five bytes written
+// Param2 :: returnValue , I2C return value of the write
+template <class Bus>
+void TEA5767N_T<Bus>::recordTransmission(const uint8_t *data, int16_t returnValue) {
+	if (returnValue == 5) {
+		// PLL word not the one in the status, injection side, band or standby change makes the status stale
+		if (!transmittedValid ||
+			(((data[FIRST_DATA] & 0x3F) << 8) | data[SECOND_DATA]) != status.pllWord ||
+			((transmitted_data[THIRD_DATA] ^ data[THIRD_DATA]) & 0b00010000) ||
+			((transmitted_data[FOURTH_DATA] ^ data[FOURTH_DATA]) & 0b01100000))
+			statusValid = false;
+		memcpy(transmitted_data, data, 5);
+		transmittedValid = true;
+	} else {
+		transmittedValid = false;
+	}
+}
+
+template <class Bus>
+void TEA5767N_T<Bus>::mute() {
 	muted = true;
 	setSoundOff();
 	transmitData();
 }
 
-void TEA5767N::setSoundOff() {
+template <class Bus>
+void TEA5767N_T<Bus>::setSoundOff() {
 	transmission_data[FIRST_DATA] |= 0b10000000;
 }
 
-void TEA5767N::turnTheSoundBackOn() {
+template <class Bus>
+void TEA5767N_T<Bus>::turnTheSoundBackOn() {
 	muted = false;
 	setSoundOn();
 	transmitData();
 }
 
-void TEA5767N::setSoundOn() {
+template <class Bus>
+void TEA5767N_T<Bus>::setSoundOn() {
 	transmission_data[FIRST_DATA] &= 0b01111111;
 }
 
-bool TEA5767N::isMuted() {
+template <class Bus>
+bool TEA5767N_T<Bus>::isMuted() {
 	return muted;
 }
 
-void TEA5767N::transmitFrequency(float frequency) {
+template <class Bus>
+void TEA5767N_T<Bus>::transmitFrequency(uint32_t frequency) {
 	setFrequency(frequency);
 	transmitData();
 }
 
-void TEA5767N::selectFrequency(float frequency) {
-	calculateOptimalHiLoInjection(frequency);
+// Tune to a frequency, injection side from the cache or probed and cached
+// Param1 :: frequency kHz
+template <class Bus>
+void TEA5767N_T<Bus>::selectFrequency(uint32_t frequency) {
+	if (!lookupInjection(frequency)) {
+		calculateOptimalHiLoInjection(frequency);
+		storeInjection(frequency);
+	}
 	transmitFrequency(frequency);
 }
 
-void TEA5767N::selectFrequencyMuting(float frequency) {
+template <class Bus>
+void TEA5767N_T<Bus>::selectFrequencyMuting(uint32_t frequency) {
 	mute();
-	calculateOptimalHiLoInjection(frequency);
-	transmitFrequency(frequency);
+	selectFrequency(frequency);
 	turnTheSoundBackOn();
 }
 
-void TEA5767N::readStatus() {
+// Tune from a PLL word and injection side kept by the caller, no cache lookup or probe
+// Param1 :: kHz , Param2 :: pllWord , see getPLLWord() , Param3 :: hiSide
+// Notes :: One register write and the ready flag settle, the status is then
+// fresh. Used to hop between known frequencies, see TEA5767AltFreq_T.
+template <class Bus>
+void TEA5767N_T<Bus>::tunePLL(uint32_t kHz, uint16_t pllWord, bool hiSide) {
+	frequency = kHz;
+	hiInjection = hiSide ? 1 : 0;
+	if (hiInjection) {
+		setHighSideLOInjection();
+	} else {
+		setLowSideLOInjection();
+	}
+	transmission_data[FIRST_DATA] = ((transmission_data[FIRST_DATA] & 0xC0) | ((pllWord >> 8) & 0x3F));
+	transmission_data[SECOND_DATA] = pllWord & 0XFF;
+	transmitData();
+}
+
+// Returns :: bool true if the station tuned uses high side injection
+template <class Bus>
+bool TEA5767N_T<Bus>::isHighSideInjection() {return hiInjection != 0;}
 
+// Read the status, a pure read needs no settle
+template <class Bus>
+void TEA5767N_T<Bus>::readStatus() {
+	readRegisters();
+	settle(TEA5767_SETTLE_NONE);
+}
+
+// Read the five status bytes from the module, no settle delay
+// Returns int16_t the I2C return value, less than zero = error
+template <class Bus>
+int16_t TEA5767N_T<Bus>::readRegisters() {
 	int16_t returnValue = 0;
-	returnValue = i2c_read_timeout_us(i2c, _i2cAddress, reception_data, 5 ,false, TEA5767_I2C_DELAY );
-	//returnValue = i2c_read_blocking(i2c, _i2cAddress, reception_data, 5 ,false); // alternative
+	asyncIdle();
+	returnValue = bus.read(_i2cAddress, reception_data, 5, TEA5767_I2C_DELAY);
 	if (bdebug == true) 
 		printf(" rx return value %d \r\n", returnValue);
-	busy_wait_ms(100);
+	decodeStatus(returnValue);
+	return returnValue;
+}
+
+// Decode reception_data into the status snapshot
+// Param1 :: returnValue , I2C return value of the read
+template <class Bus>
+void TEA5767N_T<Bus>::decodeStatus(int16_t returnValue) {
+	if (returnValue == 5) {
+		status.ready = (reception_data[FIRST_DATA] >> 7) & 1;
+		status.bandLimit = (reception_data[FIRST_DATA] >> 6) & 1;
+		status.pllWord = ((reception_data[FIRST_DATA] & 0x3F) << 8) | reception_data[SECOND_DATA];
+		status.stereo = (reception_data[THIRD_DATA] >> 7) & 1;
+		status.ifCounter = reception_data[THIRD_DATA] & 0x7F;
+		status.level = reception_data[FOURTH_DATA] >> 4;
+		status.chipID = (reception_data[FOURTH_DATA] >> 1) & 0x07;
+		status.timeStamp = to_ms_since_boot(get_absolute_time());
+		statusValid = true;
+		checkInjectionLevel(status.level);
+	} else {
+		statusValid = false;
+	}
+}
+
+// Use an asynchronous I2C transport for the seek state machine
+// Param1 :: bus , transport on the same I2C interface as begin(), nullptr = blocking calls
+// Notes :: With a transport attached each seek state only queues its transfer
+// and seekPoll() returns at once, the CPU is free while the bytes move.
+template <class Bus>
+void TEA5767N_T<Bus>::setAsyncBus(I2CAsync *bus) {
+	asyncIdle();
+	asyncBus = bus;
+}
+
+// Use SWPORT1 as the ready flag output, wired to a GPIO interrupt
+// Param1 :: gpio , PICO pin SWPORT1 is connected to, TEA5767_READY_PIN_NONE to stop
+// Param2 :: activeHigh , true if the pin goes high when ready
+// Returns :: bool , false if the pin is out of range or in use by another radio
+// Notes :: Sets the SI bit. The seek and the retune settle then wait for the
+// edge instead of reading the ready flag over I2C, one read follows for the status.
+template <class Bus>
+bool TEA5767N_T<Bus>::setReadyPin(int8_t gpio, bool activeHigh) {
+	if (readyPin != TEA5767_READY_PIN_NONE) {
+		gpio_set_irq_enabled(readyPin, TEA5767_readyEvents[readyPin], false);
+		TEA5767_readyEdges[readyPin] = nullptr;
+		TEA5767_SetReadyMask(TEA5767_readyMask & ~(1u << readyPin));
+		readyPin = TEA5767_READY_PIN_NONE;
+		transmission_data[FOURTH_DATA] &= ~SEARCH_INDICATOR_ON;
+		transmitData();
+	}
+	if (gpio == TEA5767_READY_PIN_NONE) return true;
+	if (gpio < 0 || gpio >= TEA5767_READY_PIN_COUNT || TEA5767_readyEdges[gpio] != nullptr) return false;
+
+	gpio_init(gpio);
+	gpio_set_dir(gpio, GPIO_IN);
+	gpio_pull_up(gpio); // SWPORT1 is open collector
+	TEA5767_readyEvents[gpio] = activeHigh ? GPIO_IRQ_EDGE_RISE : GPIO_IRQ_EDGE_FALL;
+	TEA5767_readyEdges[gpio] = &readyEdges;
+	TEA5767_SetReadyMask(TEA5767_readyMask | (1u << gpio));
+	gpio_acknowledge_irq(gpio, TEA5767_readyEvents[gpio]);
+	gpio_set_irq_enabled(gpio, TEA5767_readyEvents[gpio], true);
+	irq_set_enabled(IO_IRQ_BANK0, true);
+	readyPin = gpio;
+
+	transmission_data[FOURTH_DATA] |= SEARCH_INDICATOR_ON;
+	transmitData();
+	return true;
+}
+
+// Returns :: uint32_t ready edges counted on the SWPORT1 pin
+template <class Bus>
+uint32_t TEA5767N_T<Bus>::getReadyEdges() {return readyEdges;}
+
+// Queue a write of the transmission data, blocking write if no transport attached
+template <class Bus>
+void TEA5767N_T<Bus>::startWrite() {
+	if (asyncBus == nullptr) {
+		writeRegisters();
+		return;
+	}
+	memcpy(asyncTxBuffer, transmission_data, 5);
+	asyncBus->submitWrite(asyncTransfer, _i2cAddress, asyncTxBuffer, 5);
+}
+
+// Queue a read of the status, blocking read if no transport attached
+template <class Bus>
+void TEA5767N_T<Bus>::startRead() {
+	if (asyncBus == nullptr) {
+		readRegisters();
+		return;
+	}
+	asyncBus->submitRead(asyncTransfer, _i2cAddress, asyncRxBuffer, 5);
+}
+
+// Check the queued transfer, process its result once finished
+// Returns :: bool true while the transfer is still queued or on the bus
+template <class Bus>
+bool TEA5767N_T<Bus>::asyncPending() {
+	if (asyncBus == nullptr || asyncTransfer.status == I2C_ASYNC_IDLE) return false;
+	if (asyncTransfer.isPending()) {
+		asyncBus->poll();
+		if (asyncTransfer.isPending()) return true;
+	}
+	int16_t returnValue = (asyncTransfer.status == I2C_ASYNC_DONE) ? 5 : PICO_ERROR_GENERIC;
+	if (bdebug) printf(" async %s return value %d \r\n", asyncTransfer.read ? "rx" : "tx", returnValue);
+	if (asyncTransfer.read) {
+		memcpy(reception_data, asyncRxBuffer, 5);
+		decodeStatus(returnValue);
+	} else {
+		recordTransmission(asyncTxBuffer, returnValue);
+	}
+	asyncTransfer.status = I2C_ASYNC_IDLE;
+	return false;
+}
+
+// Wait for any queued transfer so a blocking call can use the bus
+template <class Bus>
+void TEA5767N_T<Bus>::asyncIdle() {
+	if (asyncBus == nullptr) return;
+	while (asyncPending()) { tight_loop_contents(); }
+	asyncBus->flush();
+}
+
+// Get the decoded module status
+// Param1 :: forceRead , true always read the module
+// Returns :: RadioStatus reference, read again only if older than the
+// freshness window (see setStatusMaxAge) or made stale by a retune.
+// Notes :: Level, stereo, ready etc. queried together share one I2C read.
+template <class Bus>
+const RadioStatus& TEA5767N_T<Bus>::getStatus(bool forceRead) {
+	if (forceRead || !statusValid ||
+		(to_ms_since_boot(get_absolute_time()) - status.timeStamp) > statusMaxAge)
+		readStatus();
+	return status;
+}
+
+// Set the status freshness window
+// Param1 :: maxAgeMs , age in mS after which getStatus reads the module again
+// 0 = read on every query.
+template <class Bus>
+void TEA5767N_T<Bus>::setStatusMaxAge(uint32_t maxAgeMs) {
+	statusMaxAge = maxAgeMs;
+}
+
+// Start a status read without waiting for it
+// Returns :: bool , false if a seek or another transfer is using the radio
+// Notes :: With an asynchronous transport the read is queued, poll
+// statusPending() until false then use getStatus(). Without one the
+// read is done at once, with no settle delay.
+template <class Bus>
+bool TEA5767N_T<Bus>::requestStatus() {
+	if (seekState != TEA5767_SEEK_IDLE || asyncPending()) return false;
+	startRead();
+	return true;
 }
 
-float TEA5767N::readFrequencyInMHz() {
+// Returns :: bool , true while a status read started by requestStatus is on the bus
+template <class Bus>
+bool TEA5767N_T<Bus>::statusPending() {
+	return asyncPending();
+}
+
+// Returns :: bool , true if the status snapshot describes the tuned station
+template <class Bus>
+bool TEA5767N_T<Bus>::isStatusValid() {return statusValid;}
+
+// Read the tuned frequency from the module
+// Returns :: uint32_t frequency in kHz, rounded to the 50 kHz channel
+template <class Bus>
+uint32_t TEA5767N_T<Bus>::readFrequencyInKHz() {
 	loadFrequency();
 	
-	unsigned int frequencyW = (((reception_data[FIRST_DATA] & 0x3F) * 256) + reception_data[SECOND_DATA]);
-	return getFrequencyInMHz(frequencyW);
+	uint16_t frequencyW = (((reception_data[FIRST_DATA] & 0x3F) * 256) + reception_data[SECOND_DATA]);
+	frequency = getFrequencyInKHz(frequencyW);
+	return frequency;
 }
 
-void TEA5767N::loadFrequency() {
+template <class Bus>
+void TEA5767N_T<Bus>::loadFrequency() {
 	readStatus();
 	
 	//Stores the read frequency that can be the result of a search and it�s not yet in transmission data
@@ -204,82 +713,584 @@ void TEA5767N::loadFrequency() {
 	transmission_data[SECOND_DATA] = reception_data[SECOND_DATA];
 }
 
-float TEA5767N::getFrequencyInMHz(unsigned int frequencyW) {
-	if (hiInjection) {
-		return (((frequencyW / 4.0) * 32768.0) - 225000.0) / 1000000.0;
-	} else {
-		return (((frequencyW / 4.0) * 32768.0) + 225000.0) / 1000000.0;
-	}
+template <class Bus>
+uint32_t TEA5767N_T<Bus>::getFrequencyInKHz(uint16_t frequencyW) {
+	return TEA5767_PLLToKHz(frequencyW, hiInjection);
 }
 
-void TEA5767N::setSearchUp() {
+template <class Bus>
+void TEA5767N_T<Bus>::setSearchUp() {
 	transmission_data[THIRD_DATA] |= 0b10000000;
 }
 
-void TEA5767N::setSearchDown() {
+template <class Bus>
+void TEA5767N_T<Bus>::setSearchDown() {
 	transmission_data[THIRD_DATA] &= 0b01111111;
 }
 
-void TEA5767N::setSearchLowStopLevel() {
+template <class Bus>
+void TEA5767N_T<Bus>::setSearchLowStopLevel() {
 	transmission_data[THIRD_DATA] &= 0b10011111;
 	transmission_data[THIRD_DATA] |= (LOW_STOP_LEVEL << 5);
 }
 
-void TEA5767N::setSearchMidStopLevel() {
+template <class Bus>
+void TEA5767N_T<Bus>::setSearchMidStopLevel() {
 	transmission_data[THIRD_DATA] &= 0b10011111;
 	transmission_data[THIRD_DATA] |= (MID_STOP_LEVEL << 5);
 }
 
-void TEA5767N::setSearchHighStopLevel() {
+template <class Bus>
+void TEA5767N_T<Bus>::setSearchHighStopLevel() {
 	transmission_data[THIRD_DATA] &= 0b10011111;
 	transmission_data[THIRD_DATA] |= (HIGH_STOP_LEVEL << 5);
 }
 
-void TEA5767N::setHighSideLOInjection() {
+template <class Bus>
+void TEA5767N_T<Bus>::setHighSideLOInjection() {
 	transmission_data[THIRD_DATA] |= 0b00010000;
 }
 
-void TEA5767N::setLowSideLOInjection() {
+template <class Bus>
+void TEA5767N_T<Bus>::setLowSideLOInjection() {
 	transmission_data[THIRD_DATA] &= 0b11101111;
 }
 
-uint8_t TEA5767N::searchNextMuting() {
-	uint8_t bandLimitReached;
-	
-	mute();
-	bandLimitReached = searchNext();
-	turnTheSoundBackOn();
-	
-	return bandLimitReached;
+template <class Bus>
+uint8_t TEA5767N_T<Bus>::searchNextMuting() {
+	seekStart(true);
+	while (!seekPoll()) { tight_loop_contents(); }
+	return seekComplete();
 }
 
-uint8_t TEA5767N::searchNext() {
-	uint8_t bandLimitReached;
-	
-	if (isSearchUp()) {
-		selectFrequency(readFrequencyInMHz() + 0.1);
-	} else {
-		selectFrequency(readFrequencyInMHz() - 0.1);
+// Blocking search, runs the asynchronous seek to completion
+// Returns uint8_t band limit reached flag, 0 and no search in standby
+template <class Bus>
+uint8_t TEA5767N_T<Bus>::searchNext() {
+	if (isStandBy()) return 0;
+	seekStart(false);
+	while (!seekPoll()) { tight_loop_contents(); }
+	return seekComplete();
+}
+
+// Blocking software seek, the chip search mode is not used
+// Returns uint8_t band limit reached flag, the radio is then at the band edge
+// Notes :: Coarse pass tunes the channels of the band plan in the search
+// direction and takes the level from the settle read. From a channel at the
+// stop level it climbs channel by channel to the local maximum, a falling edge
+// is the tail of the station behind and is passed. Only legal channels are tuned. The cached injection side is used,
+// no probe. With setSeekVerify() the peak must also pass the IF counter check.
+// With a noise profile the segment threshold replaces the fixed stop level.
+// Channels in the skip list are not tuned. Returns 0 and does nothing in
+// standby, call resume() first.
+template <class Bus>
+uint8_t TEA5767N_T<Bus>::softSearchNext() {
+	uint8_t stopLevel = TEA5767_stopLevels[(transmission_data[THIRD_DATA] >> 5) & 0x03];
+	const TEA5767_BandPlan_t &plan = TEA5767_bandPlans[bandPlan];
+	int32_t bandLow = plan.lowKHz;
+	int32_t bandHigh = plan.highKHz;
+	bool up = isSearchUp();
+	int32_t step = up ? plan.rasterKHz : -(int32_t)plan.rasterKHz;
+	int32_t startKHz = frequency;
+	uint8_t stops = 0;
+	bool wrapped = false;
+
+	if (seekIsBusy() || isStandBy()) return 0;
+	// first channel past the current frequency
+	int32_t kHz = TEA5767_NextChannel(plan, frequency, up);
+	if (up ? kHz < bandLow : kHz > bandHigh) kHz = up ? bandLow : bandHigh;
+
+	while (true) {
+		if (kHz < bandLow || kHz > bandHigh) {
+			// wrap once, the band is then searched back round to the start
+			if (!seekWrap || wrapped) break;
+			wrapped = true;
+			kHz = up ? bandLow : bandHigh;
+		}
+		if (wrapped && (up ? kHz > startKHz : kHz < startKHz)) break;
+		if (isChannelSkipped(kHz)) {
+			kHz += step;
+			continue;
+		}
+		uint8_t level = softSeekLevel(kHz);
+		uint8_t threshold = getNoiseThreshold(kHz);
+		if (level < (threshold ? threshold : stopLevel)) {
+			kHz += step;
+			continue;
+		}
+		// climb to the local maximum
+		int32_t best = kHz;
+		uint8_t bestLevel = level;
+		for (int32_t next = kHz + step; next >= bandLow && next <= bandHigh; next += step) {
+			level = softSeekLevel(next);
+			if (level <= bestLevel) break;
+			best = next;
+			bestLevel = level;
+		}
+		if (best == kHz && kHz - step >= bandLow && kHz - step <= bandHigh && softSeekLevel(kHz - step) >= bestLevel) {
+			kHz += step; // falling edge
+			continue;
+		}
+		if (isChannelSkipped(best)) {
+			seekSkippedStops++;
+			kHz = best + step;
+			continue;
+		}
+		softSeekLevel(best);
+		if (!acceptStop()) {
+			seekFalseStops++;
+			if (++stops < TEA5767_VERIFY_MAX_STOPS) {
+				if (bdebug) printf("Soft seek false stop %ld kHz, IF %u\r\n", (long)best, reception_data[THIRD_DATA] & 0x7F);
+				kHz = best + step;
+				continue;
+			}
+		}
+		if (bdebug) printf("Soft seek %ld kHz , level %u\r\n", (long)best, bestLevel);
+		return 0;
 	}
-	
-	//Turns the search on
-	transmission_data[FIRST_DATA] |= 0b01000000;
-	transmitData();
-		
-	while(!isReady()) { }
-	//Read Band Limit flag
-	bandLimitReached = isBandLimitReached();
-	//Loads the new selected frequency
-	loadFrequency();
-	
-	//Turns de search off
-	transmission_data[FIRST_DATA] &= 0b10111111;
-	transmitData();
-	
-	return bandLimitReached;
+	softSeekLevel(up ? bandHigh : bandLow);
+	return 1;
+}
+
+// Tune a channel for the software seek
+// Param1 :: kHz
+// Returns :: uint8_t ADC level read once the PLL is ready
+template <class Bus>
+uint8_t TEA5767N_T<Bus>::softSeekLevel(uint32_t kHz) {
+	lookupInjection(kHz);
+	transmitFrequency(kHz);
+	return status.level;
+}
+
+// Start an asynchronous seek in the current search direction
+// Param1 :: muting , mute audio for the duration of the seek
+// Param2 :: callback , optional, called when seek completes
+// Param3 :: userData , optional, passed to callback
+// Returns :: bool , false if a seek is already in progress or the radio is in standby
+// Notes :: Direction and stop level set by setSearchUp()/setSearchDown() etc.
+// Call seekPoll() from main loop to drive the seek, each call does at most
+// one short I2C transaction and never sleeps. In standby call resume() before
+// setting the direction, resume() writes back the bytes captured by standby().
+template <class Bus>
+bool TEA5767N_T<Bus>::seekStart(bool muting, TEA5767_SeekCallback_t callback, void *userData) {
+	if (seekState != TEA5767_SEEK_IDLE || isStandBy()) return false;
+	seekMuting = muting;
+	seekCallback = callback;
+	seekUserData = userData;
+	seekBandLimit = 0;
+	seekWrapped = false;
+	seekStops = 0;
+	seekStopBits = transmission_data[THIRD_DATA] & 0b01100000;
+	seekDeadline = get_absolute_time();
+	seekState = seekMuting ? TEA5767_SEEK_MUTE : TEA5767_SEEK_START;
+	return true;
+}
+
+// Set verified seek mode
+// Param1 :: verify , true to check each hardware stop
+// Param2 :: minLevel , ADC level 0-15 a stop needs
+// Notes :: The chip stops on level only, so at a low stop level it also stops
+// beside strong stations and on images. In verified mode a stop is accepted only
+// if the IF counter is in the correct tuning window and the level is high enough,
+// otherwise the search carries on within the same seek.
+template <class Bus>
+void TEA5767N_T<Bus>::setSeekVerify(bool verify, uint8_t minLevel) {
+	seekVerify = verify;
+	seekVerifyLevel = minLevel;
+}
+
+// Returns :: uint32_t false stops passed by verified seeks
+template <class Bus>
+uint32_t TEA5767N_T<Bus>::getSeekFalseStops() {return seekFalseStops;}
+
+// Set auto wrap at the band edges
+// Param1 :: wrap , true a seek reaching a band edge carries on from the other
+// edge, band limit is then only reported if the whole band has no station
+template <class Bus>
+void TEA5767N_T<Bus>::setSeekWrap(bool wrap) {seekWrap = wrap;}
+
+// Returns :: bool true if seeks wrap at the band edges
+template <class Bus>
+bool TEA5767N_T<Bus>::getSeekWrap() {return seekWrap;}
+
+// Check the stop the chip found, status bytes read at the stop
+// Returns :: bool true if the IF counter and level show a real carrier
+template <class Bus>
+bool TEA5767N_T<Bus>::verifyStop() {
+	uint8_t ifCounter = reception_data[THIRD_DATA] & 0x7F;
+	uint8_t level = reception_data[FOURTH_DATA] >> 4;
+	return ifCounter >= TEA5767_VERIFY_IF_LOW && ifCounter <= TEA5767_VERIFY_IF_HIGH && level >= seekVerifyLevel;
+}
+
+// Check a stop, status bytes read at the stop
+// Returns :: bool true if it passes verify (when on) and the noise threshold of its segment
+template <class Bus>
+bool TEA5767N_T<Bus>::acceptStop() {
+	uint32_t kHz = getFrequencyInKHz(((reception_data[FIRST_DATA] & 0x3F) * 256) + reception_data[SECOND_DATA]);
+	if (seekVerify && !verifyStop()) return false;
+	return (reception_data[FOURTH_DATA] >> 4) >= getNoiseThreshold(kHz);
+}
+
+// Use a noise floor profile in the seeks
+// Param1 :: profile , from calibrateNoiseFloor() or flash, nullptr for the fixed stop level
+// Param2 :: margin , ADC levels above the floor a stop needs
+// Notes :: The profile is not copied. A seek sets the chip stop level from the
+// segment it starts in, and a stop below the threshold of its segment is passed
+// like a false stop. Clean segments get a lower stop level, noisy ones a higher.
+template <class Bus>
+void TEA5767N_T<Bus>::setNoiseProfile(const TEA5767_NoiseProfile_t *profile, uint8_t margin) {
+	noiseProfile = profile;
+	noiseMargin = margin;
+}
+
+// Param1 :: kHz
+// Returns :: uint8_t ADC level a stop at kHz needs, 0 if no profile or segment not calibrated
+template <class Bus>
+uint8_t TEA5767N_T<Bus>::getNoiseThreshold(uint32_t kHz) {
+	if (noiseProfile == nullptr || kHz < TEA5767_TABLE_START_KHZ) return 0;
+	uint32_t segment = (kHz - TEA5767_TABLE_START_KHZ) / TEA5767_NOISE_SEGMENT_KHZ;
+	if (segment >= TEA5767_NOISE_SEGMENTS) segment = TEA5767_NOISE_SEGMENTS - 1;
+	uint8_t floor = (noiseProfile->floor[segment / 2] >> ((segment & 1) * 4)) & 0x0F;
+	return (floor == 0) ? 0 : floor + noiseMargin;
+}
+
+// Chip stop level for the segment of a frequency
+// Returns :: uint8_t SSL bits in place, the highest stop level at or under the
+// threshold so the chip never passes a station the threshold would accept
+template <class Bus>
+uint8_t TEA5767N_T<Bus>::segmentStopBits(uint32_t kHz) {
+	uint8_t threshold = getNoiseThreshold(kHz);
+	uint8_t ssl = 1;
+	if (threshold == 0) return seekStopBits;
+	for (uint8_t i = 2; i < 4; i++) {
+		if (TEA5767_stopLevels[i] <= threshold) ssl = i;
+	}
+	return ssl << 5;
+}
+
+// Find a segment the last search passed at too high a stop level
+// Param1 :: stopKHz , where the chip stopped or the band limit
+// Returns :: uint32_t first frequency of the segment, from seekFromKHz in the
+// search direction, that needs a lower stop level, 0 if none
+template <class Bus>
+uint32_t TEA5767N_T<Bus>::lowerStopSegment(uint32_t stopKHz) {
+	uint8_t usedBits = transmission_data[THIRD_DATA] & 0b01100000;
+	bool up = isSearchUp();
+	uint32_t kHz = seekFromKHz;
+
+	if (noiseProfile == nullptr || kHz < TEA5767_TABLE_START_KHZ) return 0;
+	while (up ? kHz < stopKHz : kHz > stopKHz) {
+		// edge of the next segment in the search direction
+		uint32_t offset = (kHz - TEA5767_TABLE_START_KHZ) % TEA5767_NOISE_SEGMENT_KHZ;
+		kHz = up ? TEA5767_SnapChannel(TEA5767_bandPlans[bandPlan], kHz - offset + TEA5767_NOISE_SEGMENT_KHZ, true) :
+			TEA5767_SnapChannel(TEA5767_bandPlans[bandPlan], kHz - offset - 1, false);
+		if (up ? kHz >= stopKHz : kHz <= stopKHz) break;
+		if (segmentStopBits(kHz) < usedBits) return kHz;
+	}
+	return 0;
+}
+
+// Calibration pass, records the noise floor of each segment of the band
+// Param1 :: profile , segments of the current band are filled in, others kept
+// Notes :: Blocking, one tune per channel of the band plan, about 1.5 S for
+// the Europe band. Audio is muted and the station restored at the end. The floor of a
+// segment is its lowest level, stations only add to the level. Run it where
+// the radio is used, the profile can then be saved to flash.
+template <class Bus>
+void TEA5767N_T<Bus>::calibrateNoiseFloor(TEA5767_NoiseProfile_t &profile) {
+	const TEA5767_BandPlan_t &plan = TEA5767_bandPlans[bandPlan];
+	uint32_t bandLow = plan.lowKHz;
+	uint32_t bandHigh = plan.highKHz;
+	uint32_t restoreKHz = frequency;
+	bool wasMuted = muted;
+
+	if (seekIsBusy()) return;
+	if (!wasMuted) mute();
+	for (uint32_t segment = (bandLow - TEA5767_TABLE_START_KHZ) / TEA5767_NOISE_SEGMENT_KHZ;
+		segment < TEA5767_NOISE_SEGMENTS; segment++) {
+		uint32_t segmentKHz = TEA5767_TABLE_START_KHZ + segment * TEA5767_NOISE_SEGMENT_KHZ;
+		uint8_t floor = 15;
+		if (segmentKHz > bandHigh) break;
+		for (uint32_t kHz = TEA5767_SnapChannel(plan, segmentKHz, true);
+			kHz < segmentKHz + TEA5767_NOISE_SEGMENT_KHZ && kHz <= bandHigh; kHz += plan.rasterKHz) {
+			uint8_t level = softSeekLevel(kHz);
+			if (level < floor) floor = level;
+		}
+		if (floor == 0) floor = 1; // 0 marks a segment not calibrated
+		uint8_t shift = (segment & 1) * 4;
+		profile.floor[segment / 2] = (profile.floor[segment / 2] & ~(0x0F << shift)) | (floor << shift);
+		if (bdebug) printf("Noise floor %lu kHz , level %u\r\n", (unsigned long)segmentKHz, floor);
+	}
+	if (restoreKHz != 0) selectFrequency(restoreKHz);
+	if (!wasMuted) turnTheSoundBackOn();
+}
+
+// Use a list of skipped channels in the seeks
+// Param1 :: list , from flash or all zero, nullptr for none
+// Notes :: The list is not copied, setChannelSkip() edits it in place. A seek
+// stopping on a skipped channel searches on within the same seek, costing the
+// one status read that found the stop. The software seek does not tune them.
+template <class Bus>
+void TEA5767N_T<Bus>::setSkipList(TEA5767_SkipList_t *list) {skipList = list;}
+
+// Add or remove a channel of the skip list
+// Param1 :: kHz , nearest PLL table channel is used
+// Param2 :: skip , true to skip, false to stop on it again
+// Returns :: bool false if no list is set or the frequency is out of band
+template <class Bus>
+bool TEA5767N_T<Bus>::setChannelSkip(uint32_t kHz, bool skip) {
+	int16_t channel = TEA5767_NearestChannel(kHz);
+	if (skipList == nullptr || channel < 0) return false;
+	if (skip)
+		skipList->bits[channel / 8] |= (1 << (channel & 7));
+	else
+		skipList->bits[channel / 8] &= ~(1 << (channel & 7));
+	return true;
+}
+
+// Param1 :: kHz
+// Returns :: bool true if the nearest channel is in the skip list
+template <class Bus>
+bool TEA5767N_T<Bus>::isChannelSkipped(uint32_t kHz) {
+	int16_t channel = TEA5767_NearestChannel(kHz);
+	if (skipList == nullptr || channel < 0) return false;
+	return (skipList->bits[channel / 8] >> (channel & 7)) & 1;
+}
+
+// Returns :: uint32_t stops on skipped channels passed by the seeks
+template <class Bus>
+uint32_t TEA5767N_T<Bus>::getSeekSkippedStops() {return seekSkippedStops;}
+
+// Select the band plan, default Europe
+// Param1 :: plan , see TEA5767_bandPlans
+// Notes :: The plan gives the channels tuneChannel(), the seeks, the scan and
+// the noise calibration visit and the band edges they stop or wrap at.
+// The chip BL bit is set per search, the Japan plan runs past the 91 MHz
+// chip limit by carrying on with the US/Europe band.
+template <class Bus>
+void TEA5767N_T<Bus>::setBandPlan(TEA5767_BandPlan_e plan) {
+	if (plan >= TEA5767_BAND_PLAN_COUNT) return;
+	bandPlan = plan;
+}
+
+// Returns :: the band plan in use, band edges and channel raster
+template <class Bus>
+const TEA5767_BandPlan_t& TEA5767N_T<Bus>::getBandPlan() {return TEA5767_bandPlans[bandPlan];}
+
+// Returns :: TEA5767_BandPlan_e index of the band plan in use
+template <class Bus>
+TEA5767_BandPlan_e TEA5767N_T<Bus>::getBandPlanIndex() {return bandPlan;}
+
+// Tune the next legal channel of the band plan, fine tune
+// Param1 :: up , true next channel up, false down
+// Returns :: uint32_t kHz tuned, wraps to the other band edge past the last channel
+// Notes :: A frequency off the raster, e.g. a preset, snaps to the channel beside it.
+// In standby the radio is resumed first, the step is from the kept tuning.
+template <class Bus>
+uint32_t TEA5767N_T<Bus>::tuneChannel(bool up) {
+	const TEA5767_BandPlan_t &plan = TEA5767_bandPlans[bandPlan];
+	if (isStandBy()) resume();
+	uint32_t kHz = TEA5767_NextChannel(plan, frequency, up);
+	if (kHz > plan.highKHz) kHz = up ? plan.lowKHz : plan.highKHz;
+	if (kHz < plan.lowKHz) kHz = up ? plan.lowKHz : plan.highKHz;
+	selectFrequency(kHz);
+	return kHz;
+}
+
+// Set the BL bit for a search starting at a frequency
+// Param1 :: kHz , below TEA5767_BAND_SPLIT_KHZ needs the Japan band
+template <class Bus>
+void TEA5767N_T<Bus>::setBandBit(uint32_t kHz) {
+	if ((kHz < TEA5767_BAND_SPLIT_KHZ ? JAPANESE_FM_BAND : US_EUROPE_FM_BAND) == JAPANESE_FM_BAND)
+		transmission_data[FOURTH_DATA] |= 0b00100000;
+	else
+		transmission_data[FOURTH_DATA] &= 0b11011111;
 }
 
-uint8_t TEA5767N::startsSearchMutingFromBeginning() {
+// Start an asynchronous seek from a given frequency in the current search direction
+// Param1 :: frequency in kHz to search from, no injection probe is done
+// Param2-4 :: as seekStart
+// Returns :: bool , false if a seek is already in progress or the radio is in standby
+template <class Bus>
+bool TEA5767N_T<Bus>::seekStartFrom(uint32_t frequency, bool muting, TEA5767_SeekCallback_t callback, void *userData) {
+	if (seekState != TEA5767_SEEK_IDLE || isStandBy()) return false;
+	setFrequency(frequency);
+	return seekStart(muting, callback, userData);
+}
+
+// Drive the asynchronous seek state machine, call from main loop
+// Returns :: bool , true once when the seek has completed
+template <class Bus>
+bool TEA5767N_T<Bus>::seekPoll() {
+	const TEA5767_BandPlan_t &plan = TEA5767_bandPlans[bandPlan];
+	uint32_t stepFrequency;
+	uint32_t stopKHz;
+	uint8_t injectionSide;
+
+	if (seekState == TEA5767_SEEK_IDLE) return false;
+	if (asyncPending()) return false;
+	if (!time_reached(seekDeadline)) return false;
+
+	switch (seekState)
+	{
+		case TEA5767_SEEK_MUTE:
+			muted = true;
+			setSoundOff();
+			startWrite();
+			seekDeadline = make_timeout_time_ms(TEA5767_SEEK_SETTLE_MS);
+			seekState = TEA5767_SEEK_START;
+		break;
+		case TEA5767_SEEK_START:
+			// Step off the current station to the next channel so the search does not stop on it again
+			stepFrequency = getFrequencyInKHz(((transmission_data[FIRST_DATA] & 0x3F) * 256) + transmission_data[SECOND_DATA]);
+			stepFrequency = TEA5767_NextChannel(plan, stepFrequency, isSearchUp());
+			if (isSearchUp() ? stepFrequency < plan.lowKHz : stepFrequency > plan.highKHz)
+				stepFrequency = isSearchUp() ? plan.lowKHz : plan.highKHz; // from outside the band
+			if (stepFrequency < plan.lowKHz || stepFrequency > plan.highKHz) {
+				// past the band edge, wrap once or report the band limit
+				if (!seekWrap || seekWrapped) {
+					seekBandLimit = 1;
+					seekState = TEA5767_SEEK_LOAD_FREQ;
+					break;
+				}
+				seekWrapped = true;
+				stepFrequency = isSearchUp() ? plan.lowKHz : plan.highKHz;
+			}
+			setFrequency(stepFrequency);
+			setBandBit(stepFrequency);
+			// stop level of the segment the search starts in
+			transmission_data[THIRD_DATA] = (transmission_data[THIRD_DATA] & 0b10011111) | segmentStopBits(stepFrequency);
+			seekFromKHz = stepFrequency;
+			//Turns the search on
+			transmission_data[FIRST_DATA] |= 0b01000000;
+			readyMark = readyEdges;
+			startWrite();
+			seekDeadline = make_timeout_time_ms(TEA5767_SEEK_POLL_MS);
+			seekTimeout = make_timeout_time_ms(TEA5767_SEEK_TIMEOUT_MS);
+			seekState = TEA5767_SEEK_WAIT_READY;
+		break;
+		case TEA5767_SEEK_WAIT_READY:
+			// with the ready pin the bus stays quiet until the edge or the timeout
+			if (readyPin != TEA5767_READY_PIN_NONE && readyEdges == readyMark && !time_reached(seekTimeout))
+				return false;
+			readyMark = readyEdges;
+			startRead();
+			seekState = TEA5767_SEEK_CHECK_READY;
+		break;
+		case TEA5767_SEEK_CHECK_READY:
+			if ((reception_data[FIRST_DATA] >> 7) || time_reached(seekTimeout)) {
+				seekState = TEA5767_SEEK_BAND_LIMIT;
+			} else {
+				seekDeadline = make_timeout_time_ms(TEA5767_SEEK_POLL_MS);
+				seekState = TEA5767_SEEK_WAIT_READY;
+			}
+		break;
+		case TEA5767_SEEK_BAND_LIMIT:
+			// status bytes already read in the ready state
+			seekBandLimit = (reception_data[FIRST_DATA] >> 6) & 1;
+			stopKHz = getFrequencyInKHz(((reception_data[FIRST_DATA] & 0x3F) * 256) + reception_data[SECOND_DATA]);
+			stepFrequency = lowerStopSegment(stopKHz);
+			if (stepFrequency != 0 && (reception_data[FIRST_DATA] >> 7)) {
+				// stop level of a noisy segment carried into a cleaner one, search that again at its own level
+				setFrequency(TEA5767_NextChannel(plan, stepFrequency, !isSearchUp()));
+				seekBandLimit = 0;
+				seekState = TEA5767_SEEK_START;
+				break;
+			}
+			if ((reception_data[FIRST_DATA] >> 7) && (seekBandLimit || stopKHz < plan.lowKHz || stopKHz > plan.highKHz)) {
+				// chip band limit or a stop outside the plan, carry on from there,
+				// the start state wraps or ends the seek at the plan edge
+				setFrequency(stopKHz < plan.lowKHz ? plan.lowKHz : (stopKHz > plan.highKHz ? plan.highKHz : stopKHz));
+				seekBandLimit = 0;
+				seekState = TEA5767_SEEK_START;
+				break;
+			}
+			if ((reception_data[FIRST_DATA] >> 7) && isChannelSkipped(TEA5767_SnapChannel(plan, stopKHz, isSearchUp()))
+				&& ++seekStops < TEA5767_VERIFY_MAX_STOPS) {
+				// skipped channel, search on past it, the stop cost one status read
+				seekSkippedStops++;
+				setFrequency(TEA5767_SnapChannel(plan, stopKHz, isSearchUp()));
+				seekState = TEA5767_SEEK_START;
+				break;
+			}
+			if (!seekBandLimit && (reception_data[FIRST_DATA] >> 7) && !acceptStop()) {
+				seekFalseStops++;
+				if (++seekStops < TEA5767_VERIFY_MAX_STOPS) {
+					// false stop, search on from where the chip stopped
+					if (bdebug) printf("Seek false stop, IF %u level %u\r\n", reception_data[THIRD_DATA] & 0x7F, reception_data[FOURTH_DATA] >> 4);
+					transmission_data[FIRST_DATA] = (transmission_data[FIRST_DATA] & 0xC0) | (reception_data[FIRST_DATA] & 0x3F);
+					transmission_data[SECOND_DATA] = reception_data[SECOND_DATA];
+					seekState = TEA5767_SEEK_START;
+					break;
+				}
+			}
+			seekState = TEA5767_SEEK_LOAD_FREQ;
+		break;
+		case TEA5767_SEEK_LOAD_FREQ:
+			//Loads the new selected frequency, Turns the search off
+			transmission_data[FIRST_DATA] = (transmission_data[FIRST_DATA] & 0xC0) | (reception_data[FIRST_DATA] & 0x3F);
+			transmission_data[SECOND_DATA] = reception_data[SECOND_DATA];
+			transmission_data[FIRST_DATA] &= 0b10111111;
+			transmission_data[THIRD_DATA] = (transmission_data[THIRD_DATA] & 0b10011111) | seekStopBits;
+			frequency = getFrequencyInKHz(((reception_data[FIRST_DATA] & 0x3F) * 256) + reception_data[SECOND_DATA]);
+			// band edge, or the stop moved on to a legal channel of the plan
+			if (seekBandLimit)
+				stopKHz = isSearchUp() ? plan.highKHz : plan.lowKHz;
+			else
+				stopKHz = TEA5767_SnapChannel(plan, frequency, isSearchUp());
+			// a cached injection side for the found station replaces the search side
+			injectionSide = hiInjection;
+			if ((lookupInjection(stopKHz) && hiInjection != injectionSide) || stopKHz != frequency) setFrequency(stopKHz);
+			// status read in wait ready stays valid if the PLL word is unchanged
+			startWrite();
+			seekDeadline = make_timeout_time_ms(TEA5767_SEEK_SETTLE_MS);
+			seekState = seekMuting ? TEA5767_SEEK_UNMUTE : TEA5767_SEEK_COMPLETE;
+		break;
+		case TEA5767_SEEK_UNMUTE:
+			muted = false;
+			setSoundOn();
+			startWrite();
+			seekState = TEA5767_SEEK_COMPLETE;
+		break;
+		case TEA5767_SEEK_COMPLETE:
+			seekState = TEA5767_SEEK_IDLE;
+			if (bdebug) printf("Seek complete %lu kHz , band limit %u\r\n", (unsigned long)frequency, seekBandLimit);
+			if (seekCallback != nullptr) seekCallback(seekBandLimit, seekUserData);
+			return true;
+		break;
+		default:
+			seekState = TEA5767_SEEK_IDLE;
+		break;
+	}
+	return false;
+}
+
+// Returns :: bool , true if an asynchronous seek is in progress
+template <class Bus>
+bool TEA5767N_T<Bus>::seekIsBusy() {
+	return seekState != TEA5767_SEEK_IDLE;
+}
+
+// Returns :: the current state of the asynchronous seek
+template <class Bus>
+TEA5767_SeekState_e TEA5767N_T<Bus>::seekGetState() {
+	return seekState;
+}
+
+// Returns :: uint8_t , band limit reached flag of the last completed seek
+template <class Bus>
+uint8_t TEA5767N_T<Bus>::seekComplete() {
+	return seekBandLimit;
+}
+
+// Returns :: uint32_t , frequency in kHz last tuned or found by a seek, no I2C traffic
+template <class Bus>
+uint32_t TEA5767N_T<Bus>::getTunedFrequencyInKHz() {
+	return frequency;
+}
+
+template <class Bus>
+uint8_t TEA5767N_T<Bus>::startsSearchMutingFromBeginning() {
 	uint8_t bandLimitReached;
 	
 	mute();
@@ -289,7 +1300,8 @@ uint8_t TEA5767N::startsSearchMutingFromBeginning() {
 	return bandLimitReached;
 }
 
-uint8_t TEA5767N::startsSearchMutingFromEnd() {
+template <class Bus>
+uint8_t TEA5767N_T<Bus>::startsSearchMutingFromEnd() {
 	uint8_t bandLimitReached;
 	
 	mute();
@@ -299,123 +1311,194 @@ uint8_t TEA5767N::startsSearchMutingFromEnd() {
 	return bandLimitReached;
 }
 
-uint8_t TEA5767N::startsSearchFromBeginning() {
+// Search up from the first channel of the band plan, it is checked too
+template <class Bus>
+uint8_t TEA5767N_T<Bus>::startsSearchFromBeginning() {
+	const TEA5767_BandPlan_t &plan = TEA5767_bandPlans[bandPlan];
 	setSearchUp();
-	return startsSearchFrom(87.0);
+	return startsSearchFrom(plan.lowKHz - plan.rasterKHz);
 }
 
-uint8_t TEA5767N::startsSearchFromEnd() {
+// Search down from the last channel of the band plan, it is checked too
+template <class Bus>
+uint8_t TEA5767N_T<Bus>::startsSearchFromEnd() {
+	const TEA5767_BandPlan_t &plan = TEA5767_bandPlans[bandPlan];
 	setSearchDown();
-	return startsSearchFrom(108.0);
+	return startsSearchFrom(plan.highKHz + plan.rasterKHz);
 }
 
-uint8_t TEA5767N::startsSearchFrom(float frequency) {
+template <class Bus>
+uint8_t TEA5767N_T<Bus>::startsSearchFrom(uint32_t frequency) {
 	selectFrequency(frequency);
 	return searchNext();
 }
 
-uint8_t TEA5767N::getSignalLevel() {
-	//Necessary before read status
-	transmitData();
-	//Read updated status
-	readStatus();
-	return reception_data[FOURTH_DATA] >> 4;
+template <class Bus>
+uint8_t TEA5767N_T<Bus>::getSignalLevel() {
+	return getStatus().level;
 }
 
-uint8_t TEA5767N::isStereo() {
-	readStatus();
-	return reception_data[THIRD_DATA] >> 7;
+template <class Bus>
+uint8_t TEA5767N_T<Bus>::isStereo() {
+	return getStatus().stereo;
 }
 
-uint8_t TEA5767N::isReady() {
-	readStatus();
-	return reception_data[FIRST_DATA] >> 7;
+template <class Bus>
+uint8_t TEA5767N_T<Bus>::isReady() {
+	return getStatus().ready;
 }
 
-uint8_t TEA5767N::isBandLimitReached() {
-	readStatus();
-	return (reception_data[FIRST_DATA] >> 6) & 1;
+template <class Bus>
+uint8_t TEA5767N_T<Bus>::isBandLimitReached() {
+	return getStatus().bandLimit;
 }
 
-uint8_t TEA5767N::isSearchUp() {
+template <class Bus>
+uint8_t TEA5767N_T<Bus>::isSearchUp() {
 	return (transmission_data[THIRD_DATA] & 0b10000000) != 0;
 }
 
-uint8_t TEA5767N::isSearchDown() {
+template <class Bus>
+uint8_t TEA5767N_T<Bus>::isSearchDown() {
 	return (transmission_data[THIRD_DATA] & 0b10000000) == 0;
 }
 
-bool TEA5767N::isStandBy() {
-	readStatus();
+template <class Bus>
+bool TEA5767N_T<Bus>::isStandBy() {
 	return (transmission_data[FOURTH_DATA] & 0b01000000) != 0;
 }
 
-void TEA5767N::setStereoReception() {
+template <class Bus>
+void TEA5767N_T<Bus>::setStereoReception() {
 	transmission_data[THIRD_DATA] &= 0b11110111;
 	transmitData();
 }
 
-void TEA5767N::setMonoReception() {
+template <class Bus>
+void TEA5767N_T<Bus>::setMonoReception() {
 	transmission_data[THIRD_DATA] |= 0b00001000;
 	transmitData();
 }
 
-void TEA5767N::setSoftMuteOn() {
+template <class Bus>
+void TEA5767N_T<Bus>::setSoftMuteOn() {
 	transmission_data[FOURTH_DATA] |= 0b00001000;
 	transmitData();
 }
 
-void TEA5767N::setSoftMuteOff() {
+template <class Bus>
+void TEA5767N_T<Bus>::setSoftMuteOff() {
 	transmission_data[FOURTH_DATA] &= 0b11110111;
 	transmitData();
 }
 
-void TEA5767N::muteRight() {
+template <class Bus>
+void TEA5767N_T<Bus>::muteRight() {
 	transmission_data[THIRD_DATA] |= 0b00000100;
 	transmitData();
 }
 
-void TEA5767N::turnTheRightSoundBackOn() {
+template <class Bus>
+void TEA5767N_T<Bus>::turnTheRightSoundBackOn() {
 	transmission_data[THIRD_DATA] &= 0b11111011;
 	transmitData();
 }
 
-void TEA5767N::muteLeft() {
+template <class Bus>
+void TEA5767N_T<Bus>::muteLeft() {
 	transmission_data[THIRD_DATA] |= 0b00000010;
 	transmitData();
 }
 
-void TEA5767N::turnTheLeftSoundBackOn() {
+template <class Bus>
+void TEA5767N_T<Bus>::turnTheLeftSoundBackOn() {
 	transmission_data[THIRD_DATA] &= 0b11111101;
 	transmitData();
 }
 
-void TEA5767N::setStandByOn() {
+template <class Bus>
+void TEA5767N_T<Bus>::setStandByOn() {
 	transmission_data[FOURTH_DATA] |= 0b01000000;
 	transmitData();
 }
 
-void TEA5767N::setStandByOff() {
+template <class Bus>
+void TEA5767N_T<Bus>::setStandByOff() {
+	transmission_data[FOURTH_DATA] &= 0b10111111;
+	transmitData();
+}
+
+// Enter standby keeping the tuning for resume()
+// Returns :: bool , false if a seek is in progress or the write failed
+// Notes :: PLL word, injection side and option bits are captured first. The
+// I2C bus stays live in standby, so no reconnect is needed on the way out.
+template <class Bus>
+bool TEA5767N_T<Bus>::standby() {
+	if (seekIsBusy()) return false;
+	if (isStandBy()) return true;
+	memcpy(standbyState.data, transmission_data, 5);
+	standbyState.frequency = frequency;
+	standbyState.hiInjection = hiInjection;
+	standbyState.muted = muted;
+	standbyState.valid = true;
+	setStandByOn();
+	return transmittedValid;
+}
+
+// Leave standby with one register write, no injection probe
+// Returns :: bool , true if the ready flag was seen before the settle deadline
+// Notes :: The bytes captured by standby() are written back, setters called
+// while in standby are overridden. Time from the write to the ready flag,
+// i.e. wake to audio, is kept for getWakeLatencyUs().
+template <class Bus>
+bool TEA5767N_T<Bus>::resume() {
+	if (!isStandBy()) return true;
+	if (standbyState.valid) {
+		memcpy(transmission_data, standbyState.data, 5);
+		frequency = standbyState.frequency;
+		hiInjection = standbyState.hiInjection;
+		muted = standbyState.muted;
+		standbyState.valid = false;
+	}
 	transmission_data[FOURTH_DATA] &= 0b10111111;
+	uint32_t timeouts = settleStats.timeouts;
+	absolute_time_t start = get_absolute_time();
 	transmitData();
+	wakeLatencyUs = (uint32_t)absolute_time_diff_us(start, get_absolute_time());
+	if (bdebug) printf(" resume %lu uS \r\n", (unsigned long)wakeLatencyUs);
+	return transmittedValid && settleStats.timeouts == timeouts;
 }
 
-void TEA5767N::setHighCutControlOn() {
+// Returns :: uint32_t uS from the resume write to the ready flag, last resume()
+template <class Bus>
+uint32_t TEA5767N_T<Bus>::getWakeLatencyUs() {return wakeLatencyUs;}
+
+template <class Bus>
+void TEA5767N_T<Bus>::setHighCutControlOn() {
 	transmission_data[FOURTH_DATA] |= 0b00000100;
 	transmitData();
 }
 
-void TEA5767N::setHighCutControlOff() {
+template <class Bus>
+void TEA5767N_T<Bus>::setHighCutControlOff() {
 	transmission_data[FOURTH_DATA] &= 0b11111011;
 	transmitData();
 }
 
-void TEA5767N::setStereoNoiseCancellingOn() {
+template <class Bus>
+void TEA5767N_T<Bus>::setStereoNoiseCancellingOn() {
 	transmission_data[FOURTH_DATA] |= 0b00000010;
 	transmitData();
 }
 
-void TEA5767N::setStereoNoiseCancellingOff() {
+template <class Bus>
+void TEA5767N_T<Bus>::setStereoNoiseCancellingOff() {
 	transmission_data[FOURTH_DATA] &= 0b11111101;
 	transmitData();
 }
+
+// Bus backends available to applications
+template class TEA5767N_T<I2CHardwareBus>;
+template class TEA5767N_T<I2CAsyncBus>;
+template class TEA5767N_T<I2CBitBangBus>;
+template class TEA5767N_T<I2CMockBus>;
@@ -0,0 +1,157 @@
+/*
+ * Project Name: Library for the TEA5767HN FM radio Stereo Module
+ * File: tea5767_af.cpp
+ * Description: library source file, alternate frequency following, hops to
+ * a stronger frequency of the same programme when the tuned one fades
+ * Toolchain :: Rpi PICO ,rp2040, SDK C++
+ * Description: See URL for full details.
+ * URL: https://github.com/gavinlyonsrepo/TEA5767_PICO
+ */
+
+#include "../include/tea5767/tea5767_af.hpp"
+
+// Constructor
+// Param1 :: the radio to tune , Param2 :: the signal monitor of that radio
+template <class Bus>
+TEA5767AltFreq_T<Bus>::TEA5767AltFreq_T(TEA5767N_T<Bus> &radio, TEA5767Monitor_T<Bus> &monitor) :
+	_radio(radio), _monitor(monitor) {
+	_nextCheck = get_absolute_time();
+}
+
+// Set the network of the programme being listened to
+// Param1 :: network , nullptr turns following off
+// Notes :: The network is not copied. Following only runs while the radio is
+// tuned to one of its frequencies, a seek or fine tune away leaves it idle.
+// The PLL word and injection side of each frequency are learned the first
+// time it is tuned and reused, a hop is then a single register write.
+template <class Bus>
+void TEA5767AltFreq_T<Bus>::setNetwork(const TEA5767_AFNetwork_t *network) {
+	_network = network;
+	for (uint8_t i = 0; i < TEA5767_AF_MAX_FREQS; i++) _hiSide[i] = TEA5767_AF_NO_SIDE;
+	_nextCheck = get_absolute_time();
+}
+
+// Set the switch thresholds
+// Param1 :: lowLevel , average ADC level under which the alternates are checked
+// Param2 :: hysteresis , levels an alternate must beat the tuned one by, stops flapping
+// Param3 :: retryMs , wait after a check that found nothing better
+template <class Bus>
+void TEA5767AltFreq_T<Bus>::setThreshold(uint8_t lowLevel, uint8_t hysteresis, uint16_t retryMs) {
+	_lowLevel = lowLevel;
+	_hysteresis = hysteresis;
+	_retryMs = retryMs;
+}
+
+// Drive the follower, call from main loop after the monitor poll()
+// Returns :: bool , true if the radio moved to an alternate, redraw the frequency
+// Notes :: Runs a check on a new monitor sample whose average level is under
+// the threshold. Nothing happens during a seek or in standby.
+template <class Bus>
+bool TEA5767AltFreq_T<Bus>::poll() {
+	TEA5767SignalStats stats;
+
+	if (_network == nullptr || _radio.seekIsBusy() || _radio.isStandBy()) return false;
+	if (_monitor.getSequence() == _sequence) return false;
+	_sequence = _monitor.getSequence();
+	_monitor.getStats(stats);
+	if (stats.count < TEA5767_AF_MIN_SAMPLES) return false;
+	if (((stats.emaLevel + 128) >> 8) >= _lowLevel) return false;
+	if (!time_reached(_nextCheck)) return false;
+	return check();
+}
+
+// Measure the alternates now and keep the best
+// Returns :: bool , true if the radio moved to an alternate
+// Notes :: Blocking, audio is muted from the first hop to the ready flag on
+// the frequency kept, about one PLL settle per alternate. The mute and the
+// first hop, and the last hop and unmute, each go in one register write.
+template <class Bus>
+bool TEA5767AltFreq_T<Bus>::check() {
+	uint8_t levels[TEA5767_AF_MAX_FREQS] = {};
+	int8_t tuned = findTuned();
+	int8_t best;
+	bool wasMuted = _radio.isMuted();
+	bool first = true;
+
+	if (tuned < 0 || _radio.seekIsBusy()) return false;
+	learn(tuned);
+	levels[tuned] = _monitor.getLevel();
+	best = tuned;
+
+	absolute_time_t start = get_absolute_time();
+	for (uint8_t i = 0; i < TEA5767_AF_MAX_FREQS; i++) {
+		if (i == tuned || _network->kHz[i] == 0) continue;
+		if (_hiSide[i] == TEA5767_AF_NO_SIDE) {
+			// first visit, the injection side is probed once with audio off
+			if (!_radio.isMuted()) _radio.mute();
+			_radio.selectFrequency(_network->kHz[i]);
+			learn(i);
+		} else {
+			_radio.beginTransaction();
+			if (first && !wasMuted) _radio.mute();
+			tune(i);
+			_radio.endTransaction();
+		}
+		first = false;
+		levels[i] = _radio.getStatus().level;
+		if (levels[i] > levels[best]) best = i;
+	}
+	if (first) return false; // no alternates
+	if (levels[best] < levels[tuned] + _hysteresis) best = tuned;
+
+	_radio.beginTransaction();
+	tune(best);
+	if (!wasMuted) _radio.turnTheSoundBackOn();
+	_radio.endTransaction();
+
+	uint32_t gapUs = (uint32_t)absolute_time_diff_us(start, get_absolute_time());
+	_stats.checks++;
+	_stats.lastGapUs = gapUs;
+	if (gapUs > _stats.maxGapUs) _stats.maxGapUs = gapUs;
+	if (best == tuned) {
+		_nextCheck = make_timeout_time_ms(_retryMs);
+		return false;
+	}
+	_stats.switches++;
+	_stats.lastSwitchUs = gapUs;
+	_monitor.clear(); // history belongs to the old frequency
+	_sequence = _monitor.getSequence();
+	return true;
+}
+
+// Returns :: the follower statistics, switch and muted gap times
+template <class Bus>
+const TEA5767_AFStats_t& TEA5767AltFreq_T<Bus>::getStats() {return _stats;}
+
+// Returns :: int8_t index in the network of the tuned frequency, -1 if not in it
+template <class Bus>
+int8_t TEA5767AltFreq_T<Bus>::findTuned() {
+	uint32_t kHz = _radio.getTunedFrequencyInKHz();
+	if (_network == nullptr) return -1;
+	for (uint8_t i = 0; i < TEA5767_AF_MAX_FREQS; i++) {
+		if (_network->kHz[i] != 0 && _network->kHz[i] == kHz) return i;
+	}
+	return -1;
+}
+
+// Keep the tuning of a frequency the radio is on now
+// Param1 :: index in the network
+template <class Bus>
+void TEA5767AltFreq_T<Bus>::learn(uint8_t index) {
+	if (_hiSide[index] != TEA5767_AF_NO_SIDE) return;
+	_hiSide[index] = _radio.isHighSideInjection() ? 1 : 0;
+	_pllWord[index] = TEA5767N_T<Bus>::getPLLWord(_network->kHz[index], _hiSide[index]);
+}
+
+// Hop to a frequency of the network from its cached tuning
+// Param1 :: index in the network
+template <class Bus>
+void TEA5767AltFreq_T<Bus>::tune(uint8_t index) {
+	_radio.tunePLL(_network->kHz[index], _pllWord[index], _hiSide[index]);
+}
+
+// Bus backends available to applications, see TEA5767N_T
+template class TEA5767AltFreq_T<I2CHardwareBus>;
+template class TEA5767AltFreq_T<I2CAsyncBus>;
+template class TEA5767AltFreq_T<I2CBitBangBus>;
+template class TEA5767AltFreq_T<I2CMockBus>;
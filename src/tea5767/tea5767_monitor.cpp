@@ -0,0 +1,209 @@
+/*
+ * Project Name: Library for the TEA5767HN FM radio Stereo Module
+ * File: tea5767_monitor.cpp
+ * Description: library source file, background signal monitor with
+ * ring buffered level, stereo and IF history
+ * Toolchain :: Rpi PICO ,rp2040, SDK C++
+ * Description: See URL for full details.
+ * URL: https://github.com/gavinlyonsrepo/TEA5767_PICO
+ */
+
+#include "../include/tea5767/tea5767_monitor.hpp"
+
+// Constructor
+// Param1 :: the radio to monitor
+template <class Bus>
+TEA5767Monitor_T<Bus>::TEA5767Monitor_T(TEA5767N_T<Bus> &radio) : _radio(radio) {
+	_stats.intervalMs = _fastMs;
+}
+
+// Set the sample rate limits
+// Param1 :: fastMs , sample interval while the signal is changing
+// Param2 :: slowMs , longest sample interval, reached by doubling while stable
+template <class Bus>
+void TEA5767Monitor_T<Bus>::setRate(uint16_t fastMs, uint16_t slowMs) {
+	if (fastMs == 0) fastMs = 1;
+	if (slowMs < fastMs) slowMs = fastMs;
+	_fastMs = fastMs;
+	_slowMs = slowMs;
+	beginWrite();
+	_stats.intervalMs = _fastMs;
+	endWrite();
+}
+
+// Drive the monitor, call from main loop
+// Returns :: bool , true when a new sample was stored
+// Notes :: Sampling pauses while a seek runs or the radio is in standby.
+// With an asynchronous transport on the radio the status read is queued
+// and picked up on a later call.
+template <class Bus>
+bool TEA5767Monitor_T<Bus>::poll() {
+	uint32_t now = to_ms_since_boot(get_absolute_time());
+
+	if (!_pending) {
+		if ((now - _lastRequest) < _stats.intervalMs) return false;
+		if (_radio.seekIsBusy() || _radio.isStandBy()) return false;
+		if (!_radio.requestStatus()) return false;
+		_lastRequest = now;
+		_pending = true;
+	}
+	if (_radio.statusPending()) return false;
+	_pending = false;
+	if (!_radio.isStatusValid()) return false;
+	store(_radio.getStatus());
+	return true;
+}
+
+// Empty the history, the next sample is taken at the fast rate
+template <class Bus>
+void TEA5767Monitor_T<Bus>::clear() {
+	beginWrite();
+	_head = 0;
+	_stats = {};
+	_stats.intervalMs = _fastMs;
+	endWrite();
+	_pllWord = -1;
+	_lastRequest = to_ms_since_boot(get_absolute_time()) - _fastMs;
+}
+
+// Add a sample and update the statistics
+// Param1 :: status read from the radio
+// Notes :: A retune starts a new history. The interval drops to the fast rate
+// when the level moves away from the average or stereo changes, and doubles
+// up to the slow rate while the signal is stable.
+template <class Bus>
+void TEA5767Monitor_T<Bus>::store(const RadioStatus &status) {
+	bool newStation = (_pllWord != status.pllWord);
+	_pllWord = status.pllWord;
+
+	beginWrite();
+	if (newStation) {
+		_head = 0;
+		_stats = {};
+	}
+
+	bool changing = (_stats.samples == 0);
+	if (!changing) {
+		int16_t average = (_stats.emaLevel + 128) >> 8;
+		int16_t delta = (int16_t)status.level - average;
+		changing = (delta >= TEA5767_MONITOR_CHANGE || delta <= -TEA5767_MONITOR_CHANGE ||
+			status.stereo != _stats.latest.stereo);
+	}
+
+	TEA5767SignalSample &sample = _history[_head];
+	sample.timeStamp = status.timeStamp;
+	sample.level = status.level;
+	sample.ifCounter = status.ifCounter;
+	sample.stereo = status.stereo;
+	_head = (_head + 1) % TEA5767_MONITOR_HISTORY;
+	if (_stats.count < TEA5767_MONITOR_HISTORY) _stats.count++;
+
+	if (_stats.samples == 0)
+		_stats.emaLevel = status.level << 8;
+	else
+		_stats.emaLevel += (((int32_t)status.level << 8) - (int32_t)_stats.emaLevel) >> TEA5767_MONITOR_EMA_SHIFT;
+	_stats.samples++;
+	_stats.latest = sample;
+
+	_stats.minLevel = 0xFF;
+	_stats.maxLevel = 0;
+	_stats.stereoCount = 0;
+	for (uint8_t i = 0; i < _stats.count; i++) {
+		if (_history[i].level < _stats.minLevel) _stats.minLevel = _history[i].level;
+		if (_history[i].level > _stats.maxLevel) _stats.maxLevel = _history[i].level;
+		if (_history[i].stereo) _stats.stereoCount++;
+	}
+
+	if (changing) {
+		_stats.intervalMs = _fastMs;
+	} else {
+		uint32_t interval = (uint32_t)_stats.intervalMs * 2;
+		_stats.intervalMs = (interval > _slowMs) ? _slowMs : interval;
+	}
+	endWrite();
+}
+
+// Sequence is odd while poll() updates the history, readers retry across an update
+template <class Bus>
+void TEA5767Monitor_T<Bus>::beginWrite() {
+	uint32_t sequence = _sequence.load(std::memory_order_relaxed);
+	_sequence.store(sequence + 1, std::memory_order_relaxed);
+	std::atomic_thread_fence(std::memory_order_release);
+}
+
+template <class Bus>
+void TEA5767Monitor_T<Bus>::endWrite() {
+	uint32_t sequence = _sequence.load(std::memory_order_relaxed);
+	_sequence.store(sequence + 1, std::memory_order_release);
+}
+
+// Copy the statistics
+// Param1 :: stats , destination
+// Notes :: Lock free, safe from the core that calls poll() or the other core.
+// Not from an interrupt that can preempt poll(), the retry would spin forever
+// on the odd sequence of the update it interrupted.
+template <class Bus>
+void TEA5767Monitor_T<Bus>::getStats(TEA5767SignalStats &stats) const {
+	uint32_t sequence;
+	do {
+		sequence = _sequence.load(std::memory_order_acquire);
+		stats = _stats;
+		std::atomic_thread_fence(std::memory_order_acquire);
+	} while ((sequence & 1) || sequence != _sequence.load(std::memory_order_relaxed));
+}
+
+// Copy a sample from the history
+// Param1 :: age , 0 = newest
+// Param2 :: sample , destination
+// Returns :: bool , false if the history holds fewer samples
+// Notes :: As getStats, not from an interrupt that can preempt poll()
+template <class Bus>
+bool TEA5767Monitor_T<Bus>::getSample(uint8_t age, TEA5767SignalSample &sample) const {
+	uint32_t sequence;
+	bool found;
+	do {
+		sequence = _sequence.load(std::memory_order_acquire);
+		found = (age < _stats.count);
+		if (found)
+			sample = _history[(_head + TEA5767_MONITOR_HISTORY - 1 - age) % TEA5767_MONITOR_HISTORY];
+		std::atomic_thread_fence(std::memory_order_acquire);
+	} while ((sequence & 1) || sequence != _sequence.load(std::memory_order_relaxed));
+	return found;
+}
+
+// Returns :: uint8_t newest signal level 0-15
+template <class Bus>
+uint8_t TEA5767Monitor_T<Bus>::getLevel() const {
+	TEA5767SignalStats stats;
+	getStats(stats);
+	return stats.latest.level;
+}
+
+// Returns :: uint8_t moving average signal level 0-15, rounded
+template <class Bus>
+uint8_t TEA5767Monitor_T<Bus>::getAverageLevel() const {
+	TEA5767SignalStats stats;
+	getStats(stats);
+	return (stats.emaLevel + 128) >> 8;
+}
+
+// Returns :: bool newest stereo flag
+template <class Bus>
+bool TEA5767Monitor_T<Bus>::isStereo() const {
+	TEA5767SignalStats stats;
+	getStats(stats);
+	return stats.latest.stereo;
+}
+
+// Returns :: uint32_t update count * 2, changes whenever a sample is stored
+// Notes :: UI code can compare it with a saved copy to redraw only on new data
+template <class Bus>
+uint32_t TEA5767Monitor_T<Bus>::getSequence() const {
+	return _sequence.load(std::memory_order_acquire);
+}
+
+// Bus backends available to applications, see TEA5767N_T
+template class TEA5767Monitor_T<I2CHardwareBus>;
+template class TEA5767Monitor_T<I2CAsyncBus>;
+template class TEA5767Monitor_T<I2CBitBangBus>;
+template class TEA5767Monitor_T<I2CMockBus>;
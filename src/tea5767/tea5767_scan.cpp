@@ -0,0 +1,232 @@
+/*
+ * Project Name: Library for the TEA5767HN FM radio Stereo Module
+ * File: tea5767_scan.cpp
+ * Description: library source file, full band scan building a station table
+ * Toolchain :: Rpi PICO ,rp2040, SDK C++
+ * Description: See URL for full details.
+ * URL: https://github.com/gavinlyonsrepo/TEA5767_PICO
+ */
+
+#include "../include/tea5767/tea5767_scan.hpp"
+
+// Constructor
+// Param1 :: the radio the scan runs on
+template <class Bus>
+TEA5767Scan_T<Bus>::TEA5767Scan_T(TEA5767N_T<Bus> &radio) : _radio(radio) {}
+
+// Start a scan of the band, the station table is cleared
+// Param1 :: startKHz lowest frequency to scan, TEA5767_SCAN_BAND_EDGE first channel of the band plan
+// Param2 :: endKHz highest frequency to scan, TEA5767_SCAN_BAND_EDGE last channel of the band plan
+// Returns :: bool , false if a scan or seek is already in progress
+// Notes :: Call poll() from the main loop until it returns 100.
+// The search stop level set on the radio is used. The radio is muted
+// for the scan and the original station restored at the end. Seek wrap
+// is off for the scan, the band limit ends it.
+template <class Bus>
+bool TEA5767Scan_T<Bus>::start(uint32_t startKHz, uint32_t endKHz) {
+	const TEA5767_BandPlan_t &plan = _radio.getBandPlan();
+	if (_busy || _radio.seekIsBusy()) return false;
+	clear();
+	_startKHz = (startKHz == TEA5767_SCAN_BAND_EDGE) ? plan.lowKHz : startKHz;
+	_endKHz = (endKHz == TEA5767_SCAN_BAND_EDGE) ? plan.highKHz : endKHz;
+	_lastKHz = 0;
+	_progress = 0;
+	_restoreKHz = _radio.getTunedFrequencyInKHz();
+	_wasMuted = _radio.isMuted();
+	if (!_wasMuted) _radio.mute();
+	_wasWrap = _radio.getSeekWrap();
+	_radio.setSeekWrap(false);
+	_radio.setSearchUp();
+	// seek steps up one channel before searching, so start one channel below
+	_radio.seekStartFrom(TEA5767_NextChannel(plan, _startKHz, false), false);
+	_busy = true;
+	return true;
+}
+
+// Drive the scan, call from main loop
+// Returns :: uint8_t progress 0-100 , 100 = scan complete
+// Notes :: Each call does at most one short I2C transaction (see TEA5767N_T::seekPoll)
+template <class Bus>
+uint8_t TEA5767Scan_T<Bus>::poll() {
+	uint32_t frequency;
+	uint8_t bandLimit;
+
+	if (!_busy) return _progress;
+	if (!_radio.seekPoll()) return _progress;
+
+	frequency = _radio.getTunedFrequencyInKHz();
+	bandLimit = _radio.seekComplete();
+	if (!bandLimit && frequency >= _startKHz && frequency <= _endKHz && frequency > _lastKHz)
+		addStation(frequency, _radio.getStatus());
+
+	if (bandLimit || frequency >= _endKHz || frequency <= _lastKHz) {
+		abort();
+		return _progress;
+	}
+	_lastKHz = frequency;
+	_progress = ((frequency - _startKHz) * 100) / (_endKHz - _startKHz);
+	if (_progress > 99) _progress = 99;
+	_radio.seekStart(false);
+	return _progress;
+}
+
+// Stop the scan, the stations found so far are kept and the original station restored
+template <class Bus>
+void TEA5767Scan_T<Bus>::abort() {
+	if (!_busy) return;
+	while (_radio.seekIsBusy()) { _radio.seekPoll(); }
+	_busy = false;
+	_progress = 100;
+	_radio.setSeekWrap(_wasWrap);
+	if (_restoreKHz != 0) _radio.selectFrequency(_restoreKHz);
+	if (!_wasMuted) _radio.turnTheSoundBackOn();
+}
+
+// Returns :: bool , true while a scan is in progress
+template <class Bus>
+bool TEA5767Scan_T<Bus>::isBusy() {return _busy;}
+
+// Returns :: uint8_t progress 0-100 of the current or last scan
+template <class Bus>
+uint8_t TEA5767Scan_T<Bus>::getProgress() {return _progress;}
+
+// Returns :: uint8_t number of stations in the table
+template <class Bus>
+uint8_t TEA5767Scan_T<Bus>::getCount() {return _count;}
+
+// Param1 :: index 0 to getCount()-1 , table is sorted by frequency
+// Returns :: the station entry
+template <class Bus>
+const TEA5767Station& TEA5767Scan_T<Bus>::getStation(uint8_t index) {
+	if (index >= _count) index = 0;
+	return _stations[index];
+}
+
+// Param1 :: index 0 to getCount()-1
+// Returns :: uint32_t station frequency in kHz
+template <class Bus>
+uint32_t TEA5767Scan_T<Bus>::getStationKHz(uint8_t index) {
+	return TEA5767_ChannelToKHz(getStation(index).channel);
+}
+
+// Returns :: int16_t index of the station with the highest level, -1 if table empty
+template <class Bus>
+int16_t TEA5767Scan_T<Bus>::getStrongest() {
+	int16_t strongest = -1;
+	for (uint8_t i = 0; i < _count; i++) {
+		if (strongest < 0 || _stations[i].level > _stations[strongest].level)
+			strongest = i;
+	}
+	return strongest;
+}
+
+// Rank the stations of the last scan, e.g. to store presets
+// Param1 :: kHz , destination, best first , Param2 :: maxCount , entries of kHz
+// Param3 :: samples , level reads averaged per station
+// Returns :: uint8_t stations written
+// Notes :: Blocking, each station is tuned once with audio muted and read
+// samples times TEA5767_RANK_INTERVAL_MS apart, about 50 mS a station. The
+// score is the average level plus TEA5767_RANK_STEREO_BONUS for stereo. A station
+// whose IF counter is outside the correct tuning window in most reads is left
+// out, it is the side of a stronger station. The tuned station is restored.
+template <class Bus>
+uint8_t TEA5767Scan_T<Bus>::rankStations(uint32_t *kHz, uint8_t maxCount, uint8_t samples) {
+	uint16_t score[TEA5767_SCAN_MAX_STATIONS] = {};
+	uint32_t restoreKHz = _radio.getTunedFrequencyInKHz();
+	bool wasMuted = _radio.isMuted();
+	uint8_t ranked = 0;
+
+	if (_busy || _radio.seekIsBusy() || samples == 0) return 0;
+	if (!wasMuted) _radio.mute();
+	for (uint8_t i = 0; i < _count; i++) {
+		uint16_t levelSum = 0;
+		uint8_t stereo = 0;
+		uint8_t ifValid = 0;
+		_radio.selectFrequency(getStationKHz(i));
+		for (uint8_t sample = 0; sample < samples; sample++) {
+			if (sample > 0) busy_wait_ms(TEA5767_RANK_INTERVAL_MS);
+			const RadioStatus &status = _radio.getStatus(true);
+			levelSum += status.level;
+			if (status.stereo) stereo++;
+			if (status.ifCounter >= TEA5767_VERIFY_IF_LOW && status.ifCounter <= TEA5767_VERIFY_IF_HIGH) ifValid++;
+		}
+		if (ifValid * 2 <= samples) continue;
+		// quarter levels, so averages of close stations still sort apart
+		score[i] = ((levelSum * 4) / samples) + ((stereo * 2 > samples) ? TEA5767_RANK_STEREO_BONUS * 4 : 0);
+	}
+
+	while (ranked < maxCount) {
+		int16_t best = -1;
+		for (uint8_t i = 0; i < _count; i++) {
+			if (score[i] != 0 && (best < 0 || score[i] > score[best])) best = i;
+		}
+		if (best < 0) break;
+		kHz[ranked++] = getStationKHz(best);
+		score[best] = 0;
+	}
+	if (restoreKHz != 0) _radio.selectFrequency(restoreKHz);
+	if (!wasMuted) _radio.turnTheSoundBackOn();
+	return ranked;
+}
+
+// Empty the station table
+template <class Bus>
+void TEA5767Scan_T<Bus>::clear() {_count = 0;}
+
+// Add a stop to the station table
+// Param1 :: frequency in kHz of the stop
+// Param2 :: status read at the stop
+// Notes :: Table stays sorted by frequency. A stop within TEA5767_SCAN_MERGE_CHANNELS
+// of an existing entry is the same transmitter, the stronger of the two is kept.
+// When full the weakest entry makes room for a stronger one.
+template <class Bus>
+void TEA5767Scan_T<Bus>::addStation(uint32_t frequency, const RadioStatus &status) {
+	int16_t channel = TEA5767_Channel(frequency);
+	uint8_t index;
+	if (channel < 0) return;
+
+	for (index = 0; index < _count; index++) {
+		int16_t distance = channel - (int16_t)_stations[index].channel;
+		if (distance >= -TEA5767_SCAN_MERGE_CHANNELS && distance <= TEA5767_SCAN_MERGE_CHANNELS) {
+			if (status.level <= _stations[index].level) return;
+			// stronger neighbour replaces the entry
+			removeStation(index);
+			break;
+		}
+	}
+
+	if (_count == TEA5767_SCAN_MAX_STATIONS) {
+		uint8_t weakest = 0;
+		for (index = 1; index < _count; index++) {
+			if (_stations[index].level < _stations[weakest].level) weakest = index;
+		}
+		if (status.level <= _stations[weakest].level) return;
+		removeStation(weakest);
+	}
+
+	index = _count;
+	while (index > 0 && _stations[index - 1].channel > channel) {
+		_stations[index] = _stations[index - 1];
+		index--;
+	}
+	_stations[index].channel = channel;
+	_stations[index].level = status.level;
+	_stations[index].stereo = status.stereo;
+	_stations[index].ifCounter = status.ifCounter;
+	_count++;
+}
+
+// Remove an entry from the station table
+// Param1 :: index 0 to getCount()-1
+template <class Bus>
+void TEA5767Scan_T<Bus>::removeStation(uint8_t index) {
+	if (index >= _count) return;
+	for (; index < _count - 1; index++) _stations[index] = _stations[index + 1];
+	_count--;
+}
+
+// Bus backends available to applications, see TEA5767N_T
+template class TEA5767Scan_T<I2CHardwareBus>;
+template class TEA5767Scan_T<I2CAsyncBus>;
+template class TEA5767Scan_T<I2CBitBangBus>;
+template class TEA5767Scan_T<I2CMockBus>;